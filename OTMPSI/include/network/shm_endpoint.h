@@ -0,0 +1,189 @@
+#ifndef OTMPSI_NETWORK_SHMENDPOINT_H_
+#define OTMPSI_NETWORK_SHMENDPOINT_H_
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "endpoint.h"
+
+using boost::asio::ip::tcp;
+
+// Capacity of the ring buffer in each direction of a shared-memory channel, must be a power of two
+const uint64 shmRingSize = 1 << 20;
+
+// Number of polls of the ring before a blocked reader or writer goes to sleep on the futex
+const int shmSpinLimit = 1024;
+
+// Control block of a single-producer single-consumer ring buffer living in shared memory
+struct ShmRingHeader {
+    alignas(64) std::atomic<uint64> head; // total number of bytes written by the producer
+    alignas(64) std::atomic<uint64> tail; // total number of bytes read by the consumer
+    alignas(64) std::atomic<uint32> data_seq; // futex word bumped by the producer after every write
+    std::atomic<uint32> reader_waiting; // set while the consumer sleeps on data_seq
+    alignas(64) std::atomic<uint32> space_seq; // futex word bumped by the consumer after every read
+    std::atomic<uint32> writer_waiting; // set while the producer sleeps on space_seq
+};
+
+static_assert(std::atomic<uint64>::is_always_lock_free, "shared-memory rings need lock-free 64-bit atomics");
+
+// Class for one direction of a shared-memory channel
+class ShmRing {
+public:
+    // Delete the default constructor
+    ShmRing() = delete;
+
+    // Constructor that takes the control block and the data area of the ring
+    ShmRing(ShmRingHeader *header, uint8 *data) : header_(header), data_(data) {};
+
+    // Method to initialize the control block of a freshly created ring
+    void Reset();
+
+    // Method to copy data into the ring, blocking while it is full, returns the number of futex calls made
+    uint64 Write(const void *buf, uint64 len);
+
+    // Method to copy as much data into the ring as fits without blocking, returns the number of bytes copied
+    uint64 TryWrite(const void *buf, uint64 len, uint64 &syscalls);
+
+    // Method to copy data out of the ring, blocking while it is empty, returns the number of futex calls made
+    uint64 Read(void *buf, uint64 len);
+
+private:
+    // Method to block until the consumer has released space, returns the number of futex calls made
+    uint64 WaitForSpace(uint64 head);
+
+    // Method to block until the producer has written data, returns the number of futex calls made
+    uint64 WaitForData(uint64 tail);
+
+    ShmRingHeader *header_;
+    uint8 *data_;
+};
+
+// Class for a shared-memory channel, made of one ring per direction in a single mapped segment. Writes never
+// block: what does not fit in the ring is queued, and a sender thread of the channel, started on first use, copies
+// it into the ring as the remote reads. A party may thus write more than the ring holds before it reads, as the
+// ring pass and the pipelined rounds do, without the parties waiting on each other's full rings.
+class ShmChannel {
+public:
+    // Delete the default constructor
+    ShmChannel() = delete;
+
+    // Constructor that maps the segment and picks the ring directions depending on which side created it
+    ShmChannel(void *segment, bool is_creator);
+
+    // Destructor that waits until the queued data is in the ring, joins the sender thread and unmaps the segment
+    ~ShmChannel();
+
+    // Size of the segment backing a channel
+    static constexpr uint64 SegmentSize() { return 2 * (sizeof(ShmRingHeader) + shmRingSize); }
+
+    // Method to write data to the channel, the part that does not fit is copied and queued, returns the number of
+    // futex calls made
+    inline uint64 Write(const void *buf, uint32 len) { return Send(static_cast<const uint8 *>(buf), len, false); }
+
+    // Method to write data to the channel, taking ownership of buf, which is freed once written, returns the number
+    // of futex calls made
+    inline uint64 AsyncWrite(void *buf, uint32 len) { return Send(static_cast<const uint8 *>(buf), len, true); }
+
+    // Method to read data from the channel, returns the number of futex calls made
+    inline uint64 Read(void *buf, uint32 len) { return in_.Read(buf, len); }
+
+private:
+    // Data waiting to be copied into the ring, owned by the channel
+    struct Message {
+        uint8 *data;
+        uint32 len;
+        uint32 offset;
+    };
+
+    // Method to copy data into the ring or queue what does not fit, taking ownership of data if owned is set
+    uint64 Send(const uint8 *data, uint32 len, bool owned);
+
+    // Loop of the sender thread
+    void SendLoop();
+
+    void *segment_;
+    ShmRing out_;
+    ShmRing in_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Message> queue_; // messages the ring had no room for, the front one may be partly written
+    bool stopping_ = false;
+    std::thread sender_;
+};
+
+// Class for a shared-memory endpoint. Connections are set up over TCP, after which all data moves through
+// shared-memory rings, so co-located parties exchange messages without going through the kernel TCP stack. A
+// segment that cannot be mapped on an incoming connection is reported as a failed connection.
+class ShmEndpoint : public Endpoint {
+public:
+    // Delete the default constructor
+    ShmEndpoint() = delete;
+
+    // Default destructor
+    ~ShmEndpoint() override = default;
+
+    // Constructor that takes the port number used to accept connection requests
+    explicit ShmEndpoint(int port) : acceptor_(io_service_, tcp::endpoint(tcp::v4(), port)), resolver_(io_service_) {};
+
+    // Method to start the endpoint
+    void Start() override;
+
+    // Method to stop the endpoint
+    void Stop() override;
+
+    // Method to stop listen
+    void StopListen() override;
+
+    // Method to connect to a remote endpoint
+    void
+    Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) override;
+
+    // Method to close a connection with a remote endpoint
+    void CloseChannel(const std::string &remote_name) override;
+
+    // Method to write data to a remote endpoint
+    void Write(const std::string &remote_name, const void *buf, uint32 len) override;
+
+    // Method to asynchronously write data to a remote endpoint, the buffer is freed once written
+    void AsyncWrite(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to read data from a remote endpoint
+    void Read(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to get the names of all connected remote endpoints
+    std::vector<std::string> GetRemoteNames() override;
+
+private:
+    // Handler for starting the endpoint
+    void StartHandler();
+
+    // Method to start accepting incoming connection requests
+    void StartAccept();
+
+    // Handler for accepting incoming connection requests
+    void AcceptHandler(const std::shared_ptr<tcp::socket> &socket, const boost::system::error_code &error);
+
+    // Method to look up the channel of a remote endpoint
+    ShmChannel &channel(const std::string &remote_name);
+
+    std::unordered_map<std::string, std::unique_ptr<ShmChannel>> channels_;
+    std::mutex channels_mtx_;
+    boost::asio::io_service io_service_;
+    tcp::acceptor acceptor_;
+    tcp::resolver resolver_;
+    bool accept_flag_ = false;
+
+    boost::thread_group tg_;
+};
+
+#endif // OTMPSI_NETWORK_SHMENDPOINT_H_
@@ -6,7 +6,10 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/thread.hpp>
+#include <netinet/tcp.h>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
@@ -24,30 +27,56 @@ using boost::asio::ip::tcp;
 const int nameSizeLimit = 128;
 const int retryLimit = 20;
 
-// Class for a TCP channel
+// Struct for the header the connecting side sends after its name, identifying one stream of a channel
+struct TcpStreamHeader {
+    uint32 index; // index of the stream within the channel
+    uint32 streams; // number of streams of the channel
+    uint32 stripe_bytes; // bytes sent on one stream before moving to the next
+};
+
+// Function to set the socket options of a TCP connection
+void ApplyTcpOptions(tcp::socket &socket, const TcpOptions &options);
+
+// Function to connect a socket to a remote address of the form "host:port", retrying while the remote is not up yet.
+// The options, if given, are applied before connecting so that the buffer sizes count for the window negotiation.
+void ConnectSocket(tcp::socket &socket, tcp::resolver &resolver, const std::string &remote_address,
+                   const TcpOptions *options = nullptr);
+
+// Class for a TCP channel. A channel may consist of several streams, i.e. TCP connections, to fill paths with a
+// large bandwidth-delay product. The byte stream of the channel is then cut into stripes that go round-robin over
+// the streams, by their offset in the byte stream, so both sides agree on the layout whatever the message sizes.
 class TcpChannel : public boost::enable_shared_from_this<TcpChannel> {
 public:
     typedef boost::shared_ptr <TcpChannel> TcpChannelPointer;
 
-    // Constructor that takes a reference to an io_service object
-    explicit TcpChannel(boost::asio::io_service &io_service) : socket_(io_service) {};
+    // Constructor that takes a reference to an io_service object, the number of streams and the stripe size
+    explicit TcpChannel(boost::asio::io_service &io_service, uint32 streams = 1, uint32 stripe_bytes = 1 << 16,
+                        bool quick_ack = false) : stripe_bytes_(stripe_bytes), quick_ack_(quick_ack) {
+        for (uint32 i = 0; i < streams; i++) {
+            sockets_.emplace_back(io_service);
+        }
+    };
 
     // Factory method to create a new TcpChannel object
-    static TcpChannelPointer Create(boost::asio::io_service &io_service) {
-        return TcpChannelPointer(new TcpChannel(io_service));
+    static TcpChannelPointer Create(boost::asio::io_service &io_service, uint32 streams = 1,
+                                    uint32 stripe_bytes = 1 << 16, bool quick_ack = false) {
+        return TcpChannelPointer(new TcpChannel(io_service, streams, stripe_bytes, quick_ack));
     }
 
     // Method to asynchronously write data to the channel
     inline void AsyncWrite(void *buf, uint32 len);
 
-    // Method to write data to the channel
-    inline void Write(const void *buf, uint32 len);
+    // Method to write data to the channel, returns the number of send calls made
+    inline uint64 Write(const void *buf, uint32 len);
 
-    // Method to read data from the channel
-    inline void Read(void *buf, uint32 len);
+    // Method to read data from the channel, returns the number of receive calls made
+    inline uint64 Read(void *buf, uint32 len);
 
-    // Method to get a reference to the underlying socket
-    inline tcp::socket &socket();
+    // Method to get a reference to the socket of a stream
+    inline tcp::socket &socket(uint32 stream = 0);
+
+    // Method to get the number of streams
+    [[nodiscard]] inline uint32 streams() const { return sockets_.size(); }
 
 private:
     // Method to write data from the buffer to the socket
@@ -56,40 +85,94 @@ private:
     // Handler for asynchronous write operations
     void WriteHandler(const boost::system::error_code &error, size_t size);
 
-    tcp::socket socket_;
+    // Method to get the stream and the number of bytes left in the stripe at an offset of the byte stream
+    inline std::pair<tcp::socket *, uint32> Stripe(uint64 offset, uint32 len);
+
+    std::vector<tcp::socket> sockets_;
+    uint32 stripe_bytes_;
+    bool quick_ack_;
+    uint64 write_offset_ = 0; // bytes written to the channel so far
+    uint64 read_offset_ = 0; // bytes read from the channel so far
     std::mutex buffer_mtx_;
     std::vector<std::pair<void *, int>> buffers_[2]; // a double buffer
     std::vector<boost::asio::const_buffer> buffer_seq_;
     int active_buffer_ = 0;
 };
 
-// Method to asynchronously write data to the channel
+// Method to asynchronously write data to the channel, striped channels write synchronously
 void TcpChannel::AsyncWrite(void *buf, uint32 len) {
+    if (sockets_.size() > 1) {
+        Write(buf, len);
+        free(buf);
+        return;
+    }
     std::lock_guard<std::mutex> lock(buffer_mtx_);
     buffers_[active_buffer_ ^ 1].emplace_back(buf, len); // move input data to the inactive buffer
     DoWrite();
 }
 
-// Method to write data to the channel
-void TcpChannel::Write(const void *buf, uint32 len) {
+// Method to get the stream and the number of bytes left in the stripe at an offset of the byte stream
+std::pair<tcp::socket *, uint32> TcpChannel::Stripe(uint64 offset, uint32 len) {
+    if (sockets_.size() == 1) {
+        return {&sockets_[0], len};
+    }
+    uint64 left = stripe_bytes_ - offset % stripe_bytes_;
+    return {&sockets_[(offset / stripe_bytes_) % sockets_.size()], static_cast<uint32>(std::min<uint64>(left, len))};
+}
+
+// Method to write data to the channel, returns the number of send calls made
+uint64 TcpChannel::Write(const void *buf, uint32 len) {
     boost::system::error_code error;
-    boost::asio::write(socket_, boost::asio::buffer(buf, len), error);
+    auto src = static_cast<const uint8 *>(buf);
+    uint64 calls = 0;
+    while (len > 0 && !error) {
+        auto [socket, stripe_len] = Stripe(write_offset_, len);
+        // Loop over write_some instead of boost::asio::write so that every send call is counted
+        for (uint32 written = 0; written < stripe_len && !error; calls++) {
+            written += socket->write_some(boost::asio::buffer(src + written, stripe_len - written), error);
+        }
+        src += stripe_len;
+        len -= stripe_len;
+        write_offset_ += stripe_len;
+    }
     if (error) {
         std::cerr << "Error writing to socket: " << error.message() << std::endl;
     }
+    return calls;
 }
 
-// Method to read data from the channel
-void TcpChannel::Read(void *buf, uint32 len) {
+// Method to read data from the channel, returns the number of receive calls made
+uint64 TcpChannel::Read(void *buf, uint32 len) {
     boost::system::error_code error;
-    boost::asio::read(socket_, boost::asio::buffer(buf, len), error);
+    auto dst = static_cast<uint8 *>(buf);
+    uint64 calls = 0;
+    while (len > 0 && !error) {
+        auto [socket, stripe_len] = Stripe(read_offset_, len);
+        // Loop over read_some instead of boost::asio::read so that every receive call is counted
+        for (uint32 read = 0; read < stripe_len && !error; calls++) {
+            read += socket->read_some(boost::asio::buffer(dst + read, stripe_len - read), error);
+#ifdef TCP_QUICKACK
+            // The kernel falls back to delayed acknowledgements after a while, so quick acks are re-armed
+            if (quick_ack_) {
+                boost::system::error_code ignored;
+                socket->set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK>(true),
+                                   ignored);
+                calls++;
+            }
+#endif
+        }
+        dst += stripe_len;
+        len -= stripe_len;
+        read_offset_ += stripe_len;
+    }
     if (error) {
         std::cerr << "Error reading from socket: " << error.message() << std::endl;
     }
+    return calls;
 }
 
-// Method to get a reference to the underlying socket
-tcp::socket &TcpChannel::socket() { return socket_; }
+// Method to get a reference to the socket of a stream
+tcp::socket &TcpChannel::socket(uint32 stream) { return sockets_[stream]; }
 
 // Class for a TCP endpoint
 class TcpEndpoint : public Endpoint {
@@ -100,8 +183,8 @@ public:
     // Default destructor
     ~TcpEndpoint() override = default;
 
-    // Constructor that takes a port number
-    explicit TcpEndpoint(int port) : acceptor_(io_service_, tcp::endpoint(tcp::v4(), port)), resolver_(io_service_) {};
+    // Constructor that takes a port number and the options of the channels
+    explicit TcpEndpoint(int port, const TcpOptions &options = TcpOptions());
 
     // Method to start the endpoint
     inline void Start() override;
@@ -131,15 +214,6 @@ public:
     void
     Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) override;
 
-    // Method to get the total amount of data sent in a more readable form
-    uint64 GetTotalBytesSent() const override;
-
-    // Method to get the total amount of data received in a more readable form
-    uint64 GetTotalBytesReceived() const override;
-
-    // Method to reset the total amount of data sent and received
-    void ResetCounters() override;
-
 private:
     // Handler for starting the endpoint
     inline void StartHandler();
@@ -148,21 +222,19 @@ private:
     inline void StartAccept();
 
     // Handler for accepting incoming connections
-    inline void AcceptHandler(const TcpChannel::TcpChannelPointer &new_connection,
-                              const boost::system::error_code &error);
+    inline void AcceptHandler(const std::shared_ptr<tcp::socket> &socket, const boost::system::error_code &error);
 
+    TcpOptions options_;
     std::unordered_map<std::string, TcpChannel::TcpChannelPointer> channels_;
+    // channels of which not all streams have been accepted yet, with the number of accepted streams
+    std::unordered_map<std::string, std::pair<TcpChannel::TcpChannelPointer, uint32>> pending_channels_;
+    std::mutex channels_mtx_;
     boost::asio::io_service io_service_;
     tcp::acceptor acceptor_;
     tcp::resolver resolver_;
     bool accept_flag;
 
     boost::thread_group tg;
-
-    //member variables to record the time and amount of data sent/received
-    uint64 total_bytes_sent_ = 0;
-    uint64 total_bytes_received_ = 0;
-    std::chrono::duration<double> total_network_time_ = std::chrono::duration<double>::zero();
 };
 
 // Method to start the endpoint
@@ -171,7 +243,10 @@ void TcpEndpoint::Start() {
 };
 
 // Method to close a connection with a remote endpoint
-void TcpEndpoint::CloseChannel(const std::string &remote_name) { channels_.erase(remote_name); };
+void TcpEndpoint::CloseChannel(const std::string &remote_name) {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    channels_.erase(remote_name);
+};
 
 
 // Method to stop the endpoint  listen
@@ -182,19 +257,24 @@ void TcpEndpoint::StopListen() {
 
 // Method to write data to a remote endpoint
 void TcpEndpoint::Write(const std::string &remote_name, const void *buf, uint32 len) {
-    channels_[remote_name]->Write(buf, len);
-    total_bytes_sent_ += len;
+    auto start = TrafficStats::Clock::now();
+    auto syscalls = channels_[remote_name]->Write(buf, len);
+    stats_.RecordWrite(remote_name, len, syscalls, start);
 };
 
-// Method to asynchronously write data to a remote endpoint
+// Method to asynchronously write data to a remote endpoint. The send calls happen later on the io_service thread
+// and are not counted.
 void TcpEndpoint::AsyncWrite(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
     channels_[remote_name]->AsyncWrite(buf, len);
+    stats_.RecordWrite(remote_name, len, 0, start);
 };
 
 // Method to read data from a remote endpoint
 void TcpEndpoint::Read(const std::string &remote_name, void *buf, uint32 len) {
-    channels_[remote_name]->Read(buf, len);
-    total_bytes_received_ += len;
+    auto start = TrafficStats::Clock::now();
+    auto syscalls = channels_[remote_name]->Read(buf, len);
+    stats_.RecordRead(remote_name, len, syscalls, start);
 };
 
 // Handler for starting the endpoint
@@ -206,22 +286,41 @@ void TcpEndpoint::StartHandler() {
 
 // Method to start accepting incoming connections
 void TcpEndpoint::StartAccept() {
-    TcpChannel::TcpChannelPointer new_connection = TcpChannel::Create(this->io_service_);
-    acceptor_.async_accept(new_connection->socket(), boost::bind(&TcpEndpoint::AcceptHandler, this, new_connection,
-                                                                 boost::asio::placeholders::error));
+    auto socket = std::make_shared<tcp::socket>(this->io_service_);
+    acceptor_.async_accept(*socket, boost::bind(&TcpEndpoint::AcceptHandler, this, socket,
+                                                boost::asio::placeholders::error));
 };
 
-// Handler for accepting incoming connections
-void TcpEndpoint::AcceptHandler(const TcpChannel::TcpChannelPointer &new_connection,
-                                const boost::system::error_code &error) {
+// Handler for accepting incoming connections. Every stream of a channel is a connection of its own, the channel
+// becomes visible once all its streams are accepted.
+void TcpEndpoint::AcceptHandler(const std::shared_ptr<tcp::socket> &socket, const boost::system::error_code &error) {
     if (accept_flag) {
         if (error) {
             std::cerr << "Error accepting connection: " << error.message() << std::endl;
         } else {
-            uint8 buffer[nameSizeLimit];
-            new_connection->Read(buffer, nameSizeLimit);
-            std::string remoteName(reinterpret_cast<char *>(buffer));
-            channels_.insert(std::make_pair(remoteName, new_connection));
+            char buffer[nameSizeLimit];
+            TcpStreamHeader header{};
+            boost::asio::read(*socket, boost::asio::buffer(buffer, nameSizeLimit));
+            boost::asio::read(*socket, boost::asio::buffer(&header, sizeof(header)));
+            std::string remoteName(buffer);
+            if (header.streams == 0 || header.index >= header.streams || header.stripe_bytes == 0) {
+                std::cerr << "Error accepting connection: bad stream header from " << remoteName << std::endl;
+                StartAccept();
+                return;
+            }
+            ApplyTcpOptions(*socket, options_);
+
+            std::lock_guard<std::mutex> lock(channels_mtx_);
+            auto &[channel, accepted] = pending_channels_[remoteName];
+            if (!channel) {
+                channel = TcpChannel::Create(this->io_service_, header.streams, header.stripe_bytes,
+                                             options_.quick_ack);
+            }
+            channel->socket(header.index) = std::move(*socket);
+            if (++accepted == header.streams) {
+                channels_.insert(std::make_pair(remoteName, channel));
+                pending_channels_.erase(remoteName);
+            }
         }
         StartAccept();
     }
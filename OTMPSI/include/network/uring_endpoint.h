@@ -0,0 +1,209 @@
+#ifndef OTMPSI_NETWORK_URINGENDPOINT_H_
+#define OTMPSI_NETWORK_URINGENDPOINT_H_
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define OTMPSI_HAVE_IO_URING 1
+#endif
+
+#ifdef OTMPSI_HAVE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "endpoint.h"
+
+using boost::asio::ip::tcp;
+
+// Number of submission queue entries of the ring
+const uint32 uringQueueDepth = 64;
+
+// Size of each registered send buffer, larger writes are split over several buffers
+const uint32 uringBufferSize = 1 << 18;
+
+// Number of registered send buffers shared by all channels, 4 MiB in total stays below the default memlock limit
+const uint32 uringBufferCount = 16;
+
+// Class for a minimal io_uring instance, talking to the kernel directly
+class UringQueue {
+public:
+    // Delete the default constructor
+    UringQueue() = delete;
+
+    // Constructor that sets up a ring with the given number of entries and maps its queues
+    explicit UringQueue(uint32 entries);
+
+    // Destructor that unmaps the queues and closes the ring
+    ~UringQueue();
+
+    // Method to get a cleared submission entry, submitting queued entries first if the queue is full
+    io_uring_sqe *GetSqe();
+
+    // Method to submit all queued entries and wait for at least wait_nr completions, in a single system call
+    void Submit(uint32 wait_nr);
+
+    // Method to take the next completion, returns false if none is available
+    bool PeekCqe(io_uring_cqe &cqe);
+
+    // Method to wait for and take the next completion
+    void WaitCqe(io_uring_cqe &cqe);
+
+    // Method to register buffers for fixed reads and writes, returns false if the kernel refuses to pin them
+    bool RegisterBuffers(const std::vector<iovec> &buffers);
+
+    // Method to check whether the kernel supports an operation
+    bool Supports(uint8 opcode);
+
+    // Method to get the number of system calls made to submit and wait so far
+    [[nodiscard]] inline uint64 syscalls() const { return syscalls_; }
+
+private:
+    int fd_;
+    void *sq_ring_;
+    size_t sq_ring_size_;
+    void *cq_ring_;
+    size_t cq_ring_size_;
+    io_uring_sqe *sqes_;
+    uint32 sq_entries_;
+
+    uint32 *sq_head_;
+    uint32 *sq_tail_;
+    uint32 *sq_mask_;
+    uint32 *sq_array_;
+    uint32 *cq_head_;
+    uint32 *cq_tail_;
+    uint32 *cq_mask_;
+    io_uring_cqe *cqes_;
+
+    uint32 local_tail_ = 0; // tail including entries not yet published to the kernel
+    uint32 to_submit_ = 0;
+    uint64 syscalls_ = 0;
+};
+
+// Class for a TCP endpoint that moves data through io_uring. Writes are copied into registered buffers and handed
+// to the kernel before returning, without waiting for the send to finish; send completions are reaped from the ring
+// without system calls, and a read submits the receive and waits for it in a single call. Buffers of at least the
+// zero-copy threshold are sent with zero-copy sends when the kernel supports them. Calls are serialized on one
+// ring, as the protocol drives the endpoint from a single thread.
+class UringEndpoint : public Endpoint {
+public:
+    // Delete the default constructor
+    UringEndpoint() = delete;
+
+    // Constructor that takes the port number used to accept connections and the zero-copy threshold
+    UringEndpoint(int port, uint32 zero_copy_threshold);
+
+    // Destructor that releases the registered buffers
+    ~UringEndpoint() override;
+
+    // Method to start the endpoint
+    void Start() override;
+
+    // Method to stop the endpoint
+    void Stop() override;
+
+    // Method to stop listen
+    void StopListen() override;
+
+    // Method to connect to a remote endpoint
+    void
+    Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) override;
+
+    // Method to close a connection with a remote endpoint
+    void CloseChannel(const std::string &remote_name) override;
+
+    // Method to write data to a remote endpoint
+    void Write(const std::string &remote_name, const void *buf, uint32 len) override;
+
+    // Method to asynchronously write data to a remote endpoint, the buffer is freed once copied
+    void AsyncWrite(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to read data from a remote endpoint
+    void Read(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to get the names of all connected remote endpoints
+    std::vector<std::string> GetRemoteNames() override;
+
+private:
+    // State of a connection
+    struct Channel {
+        explicit Channel(tcp::socket socket) : socket(std::move(socket)) {};
+
+        tcp::socket socket;
+        std::deque<int> queued; // buffers waiting for the send in flight
+        bool sending = false; // whether a send of this channel is in flight
+    };
+
+    // State of a registered send buffer
+    struct SendBuffer {
+        uint8 *data;
+        Channel *channel = nullptr;
+        uint32 len = 0; // bytes copied into the buffer
+        uint32 sent = 0; // bytes acknowledged by the kernel
+        uint32 notifications = 0; // zero-copy notifications still to come
+    };
+
+    // Handler for starting the endpoint
+    void StartHandler();
+
+    // Method to start accepting incoming connection requests
+    void StartAccept();
+
+    // Handler for accepting incoming connection requests
+    void AcceptHandler(const std::shared_ptr<tcp::socket> &socket, const boost::system::error_code &error);
+
+    // Method to add a connected socket under a remote name
+    void AddChannel(const std::string &remote_name, tcp::socket socket);
+
+    // Method to look up the channel of a remote endpoint
+    Channel &channel(const std::string &remote_name);
+
+    // Method to take a free registered buffer, reaping completions until one is released
+    int AcquireBuffer();
+
+    // Method to start sending the next queued buffer of a channel
+    void SendNext(Channel &channel);
+
+    // Method to queue a send of the unsent part of a buffer
+    void PrepareSend(int index);
+
+    // Method to return a buffer to the free list once it is sent and the kernel no longer references it
+    void ReleaseIfDone(int index);
+
+    // Method to handle a completion
+    void Complete(const io_uring_cqe &cqe);
+
+    // Method to wait until no send is in flight
+    void Drain();
+
+    std::unordered_map<std::string, std::unique_ptr<Channel>> channels_;
+    std::mutex channels_mtx_;
+    std::mutex io_mtx_; // guards the ring and the buffers
+    boost::asio::io_service io_service_;
+    tcp::acceptor acceptor_;
+    tcp::resolver resolver_;
+    bool accept_flag_ = false;
+    boost::thread_group tg_;
+
+    UringQueue ring_;
+    uint8 *buffer_memory_;
+    std::vector<SendBuffer> buffers_;
+    std::vector<int> free_buffers_;
+    bool fixed_buffers_; // whether the buffers are registered with the kernel
+    uint32 zero_copy_threshold_; // buffers with at least this many bytes are sent without copying, 0 disables
+    bool zero_copy_supported_;
+    bool receive_done_ = false;
+    int receive_result_ = 0;
+};
+
+#endif // OTMPSI_HAVE_IO_URING
+
+#endif // OTMPSI_NETWORK_URINGENDPOINT_H_
@@ -5,19 +5,26 @@
 #include <vector>
 
 #include "crypto/threshold_elgamal.h"
-#include "network/tcp_endpoint.h"
+#include "network/endpoint.h"
 #include "utils/bloom_filter.h"
 #include "utils/common.h"
+#include "utils/zz_codec.h"
 
 class Participant : KeyHolder {
 public:
-    // Constructor
+    // Constructor that creates the endpoint selected by the transport option
     Participant(const Options &options, const std::vector<ElementType> &set)
+            : Participant(options, set, NewEndpoint(options)) {};
+
+    // Constructor that takes the endpoint used to reach the other participants
+    Participant(const Options &options, const std::vector<ElementType> &set, Endpoint *endpoint)
             : KeyHolder(options.p, options.alpha, options.phi_p_prime_factor_list),
-              endpoint_(new TcpEndpoint(options.port)),
+              endpoint_(endpoint),
               elements_(set),
-              bf_(options.bloom_filter_size, options.murmurhash_seeds),
-              options_(options) {
+              bf_(options.bloom_filter_size, options.murmurhash_seeds, options.bloom_filter_layout,
+                  options.bloom_filter_block_bits),
+              options_(options),
+              codec_(options.num_bytes_field_numbers, options.zz_format) {
         endpoint_->Start();
     };
 
@@ -30,8 +37,13 @@ public:
     // Get the role of the participant
     [[nodiscard]] Role role() const { return options_.role; };
 
-    // Change the element set of the participant
-    void ChangeElementSet(const std::vector<ElementType> &new_set) { elements_ = new_set; };
+    // Change the element set of the participant, the positions of the elements are kept if the set is the same
+    void ChangeElementSet(const std::vector<ElementType> &new_set) {
+        if (new_set != elements_) {
+            elements_ = new_set;
+            positions_.Clear();
+        }
+    };
 
     // Initialize the participant
     void Initialize();
@@ -61,9 +73,16 @@ private:
     // Bloom filter of the participant
     BloomFilter bf_;
 
+    // Positions of the elements in the Bloom filter, computed once per element set
+    HashPositionMatrix positions_;
+
     // Options for the protocol
     Options options_;
 
+    // Codec for batches of numbers and the buffer they are encoded into
+    ZzCodec codec_;
+    std::vector<uint8> wire_buffer_;
+
     // Perform distributed key generation
     void DistributedKeyGeneration();
 
@@ -79,8 +98,11 @@ private:
     void Decrypt(std::vector<NTL::ZZ> &decrypted_bases, std::vector<Ciphertext> &encrypted_bases,
                  const std::vector<Ciphertext> &rerand_array);
 
+    // Write the traffic statistics of the endpoint to the configured file, if any
+    void WriteStatistics() const;
+
     // Find the intersection of the sets
-    void FindIntersection(std::vector<std::pair<int, uint64>> &intersection,
+    void FindIntersection(std::vector<std::pair<int, ElementType>> &intersection,
                           const std::vector<NTL::ZZ> &decrypted_bases);
 
     // Send an NTL::ZZ to a remote participant
@@ -101,6 +123,18 @@ private:
     // Receive a ciphertext from a remote participant
     inline void ReceiveCiphertext(const std::string &remote, Ciphertext &ciphertext);
 
+    // Send a batch of ciphertexts to a remote participant in one message
+    void SendCiphertexts(const std::string &remote, const Ciphertext *ciphertexts, uint64 count);
+
+    // Receive a batch of ciphertexts from a remote participant in one message
+    void ReceiveCiphertexts(const std::string &remote, Ciphertext *ciphertexts, uint64 count);
+
+    // Send the batch encoded into the wire buffer up to end
+    void SendBatch(const std::string &remote, const uint8 *end);
+
+    // Receive a batch of count numbers into the wire buffer, returns the start of the encoded numbers
+    const uint8 *ReceiveBatch(const std::string &remote, uint64 count);
+
     // Broadcast a ciphertext to all remote participants
     void BroadcastCiphertext(const Ciphertext &ciphertext);
 
@@ -139,7 +173,12 @@ private:
     void DecryptClient();
 
     // Find the intersection of the sets for the server participant
-    void FindIntersectionServer(std::vector<std::pair<int, uint64>> &intersection,
+    void FindIntersectionServer(std::vector<std::pair<int, ElementType>> &intersection,
+                                const std::vector<NTL::ZZ> &decrypted_bases);
+
+    // Find the intersection of the sets for the server participant, counting votes in counters of CounterBits bits
+    template<uint32 CounterBits>
+    void FindIntersectionServer(std::vector<std::pair<int, ElementType>> &intersection,
                                 const std::vector<NTL::ZZ> &decrypted_bases);
 
     // Perform mutual decryption for the server participant
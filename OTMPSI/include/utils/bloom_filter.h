@@ -3,10 +3,124 @@
 
 #include <NTL/ZZ.h>
 
-#include <boost/dynamic_bitset.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <span>
 #include <vector>
 
 #include "common.h"
+#include "third_party/smhasher/MurmurHash3.h"
+
+// Method to map a uniformly distributed 64-bit value onto [0, n) with a multiplication instead of a division
+inline uint64 FastRange64(uint64 x, uint64 n) {
+    return static_cast<uint64>((static_cast<unsigned __int128>(x) * n) >> 64);
+}
+
+// Method to map a uniformly distributed 32-bit value onto [0, n) with a multiplication instead of a division
+inline uint32 FastRange32(uint32 x, uint32 n) {
+    return static_cast<uint32>((static_cast<uint64>(x) * n) >> 32);
+}
+
+// Class for computing the remainder of 64-bit values by a fixed divisor with multiplications instead of a division,
+// exact for all values and divisors (Lemire, Kaser and Kurz, Faster Remainder by Direct Computation)
+class FastModulo {
+public:
+    // Constructor that takes the divisor
+    explicit FastModulo(uint64 d) : d_(d), m_(~static_cast<unsigned __int128>(0) / d + 1) {};
+
+    // Method to get x modulo the divisor
+    [[nodiscard]] inline uint64 operator()(uint64 x) const {
+        unsigned __int128 low_bits = m_ * x;
+        unsigned __int128 t = (static_cast<unsigned __int128>(static_cast<uint64>(low_bits)) * d_) >> 64;
+        t += static_cast<unsigned __int128>(static_cast<uint64>(low_bits >> 64)) * d_;
+        return static_cast<uint64>(t >> 64);
+    }
+
+private:
+    uint64 d_;
+    unsigned __int128 m_;
+};
+
+// Class for deriving the positions of an element in a Bloom filter. The seeded layout hashes the element once per
+// seed and reduces every hash modulo the size. The hashed layout hashes the element once with the first seed and
+// derives all positions from the two halves of the 128-bit hash by enhanced double hashing, reduced with
+// multiplications. The blocked layout picks a block of the filter with the first half and derives all positions
+// inside that block from the second half, so the positions of an element are close to each other.
+class BloomFilterHasher {
+public:
+    // Delete the default constructor
+    BloomFilterHasher() = delete;
+
+    // Constructor that takes the size of the filter, the MurmurHash seeds, the layout and the size of a block
+    BloomFilterHasher(ContainerSizeType size, const std::vector<uint32> &murmurhash_seeds,
+                      BloomFilterLayout layout = BloomFilterLayout::seeded, uint32 block_bits = 512);
+
+    // Method to get the size of the filter
+    [[nodiscard]] inline ContainerSizeType size() const { return size_; }
+
+    // Method to get the number of positions of an element
+    [[nodiscard]] inline uint32 num_hashes() const { return murmurhash_seeds_.size(); }
+
+    // Method to call f with every position of an element, stops early once f returns false
+    template<typename F>
+    inline void ForEachPosition(const ElementType &e, F f) const;
+
+    // Method to write the positions of count elements to positions, the positions of element i start at index
+    // i * num_hashes(). The elements are hashed in batches by the vector kernels.
+    void Positions(const ElementType *elements, uint64 count, ContainerSizeType *positions) const;
+
+private:
+    // Method to call f with every position derived from the 128-bit hash of an element, for the hashed layouts
+    template<typename F>
+    inline void DerivePositions(const uint64 *hash, F f) const;
+
+    ContainerSizeType size_;
+    FastModulo size_modulo_; // gives the same positions as hash % size_
+    std::vector<uint32> murmurhash_seeds_;
+    BloomFilterLayout layout_;
+    uint32 block_bits_;
+    ContainerSizeType num_blocks_; // the last block also takes the positions left over by the others
+};
+
+// Class for the positions of all elements of a set in a Bloom filter, one row of num_hashes() positions per element.
+// The rows are computed once per set and shared by building the filter and testing membership.
+class HashPositionMatrix {
+public:
+    // Default constructor, for an empty matrix
+    HashPositionMatrix() = default;
+
+    // Method to compute the positions of all elements, in parallel
+    void Compute(const BloomFilterHasher &hasher, const std::vector<ElementType> &elements, uint32 num_threads);
+
+    // Method to drop the positions, e.g. when the set changes
+    inline void Clear() { computed_ = false; }
+
+    // Method to check if the positions are computed
+    [[nodiscard]] inline bool computed() const { return computed_; }
+
+    // Method to get the number of elements
+    [[nodiscard]] inline uint64 rows() const { return rows_; }
+
+    // Method to get the number of positions of an element
+    [[nodiscard]] inline uint32 num_hashes() const { return num_hashes_; }
+
+    // Method to get the positions of element i
+    [[nodiscard]] inline const ContainerSizeType *row(uint64 i) const { return data_.get() + i * num_hashes_; }
+
+private:
+    // Deleter for the cache aligned storage
+    struct AlignedFree {
+        void operator()(ContainerSizeType *p) const { std::free(p); }
+    };
+
+    std::unique_ptr<ContainerSizeType[], AlignedFree> data_; // rows one after another, starting at a cache line
+    uint64 capacity_ = 0; // number of positions the storage holds
+    uint64 rows_ = 0;
+    uint32 num_hashes_ = 0;
+    bool computed_ = false;
+};
 
 // Class for a Bloom filter
 class BloomFilter {
@@ -17,9 +131,11 @@ public:
     // Default destructor
     ~BloomFilter() = default;
 
-    // Constructor that takes the size of the filter and a vector of MurmurHash seeds
-    BloomFilter(const ContainerSizeType &size, const std::vector<uint32> &murmurhash_seeds)
-            : size_(size), bit_array_(boost::dynamic_bitset<>(size)), murmurhash_seeds_(murmurhash_seeds) {};
+    // Constructor that takes the size of the filter, a vector of MurmurHash seeds, the layout and the size of a block
+    BloomFilter(const ContainerSizeType &size, const std::vector<uint32> &murmurhash_seeds,
+                BloomFilterLayout layout = BloomFilterLayout::seeded, uint32 block_bits = 512)
+            : size_(size), words_((size + 63) / 64),
+              hasher_(size, murmurhash_seeds, layout, block_bits) {};
 
     // Method to get the size of the filter
     [[nodiscard]] inline ContainerSizeType size() const;
@@ -31,7 +147,7 @@ public:
     inline void Clear();
 
     // Method to check if a position in the filter is set
-    inline bool CheckPosition(const ContainerSizeType &pos);
+    inline bool CheckPosition(const ContainerSizeType &pos) const;
 
     // Method to insert an element into the filter
     void Insert(const ElementType &e);
@@ -39,26 +155,60 @@ public:
     // Method to check if an element is in the filter
     bool CheckElement(const ElementType &e);
 
+    // Method to insert all elements of a set into the filter, hashing them in batches on num_threads threads
+    void InsertAll(std::span<const ElementType> elements, uint32 num_threads = 1);
+
+    // Method to insert all elements of a set into the filter, from their precomputed positions, on num_threads threads
+    void InsertAll(const HashPositionMatrix &positions, uint32 num_threads = 1);
+
+    // Method to check which elements of a set are in the filter on num_threads threads, found[i] is set to 1 if
+    // element i is and to 0 otherwise
+    void CheckAll(std::span<const ElementType> elements, std::span<uint8> found, uint32 num_threads = 1) const;
+
+    // Method to get the hasher deriving the positions of elements
+    [[nodiscard]] inline const BloomFilterHasher &hasher() const { return hasher_; }
+
 private:
+    // Method to set the bits at count positions, with atomic ORs if other threads set bits of the filter at the same time
+    void SetPositions(const ContainerSizeType *positions, uint64 count, bool concurrent);
+
     ContainerSizeType size_; // size of the bloom filter
-    boost::dynamic_bitset<> bit_array_; // underlying bit array
-    std::vector<uint32> murmurhash_seeds_; // murmurhash seeds for hash functions
+    std::vector<uint64> words_; // underlying bits, 64 to a word, the bits past the size stay clear
+    BloomFilterHasher hasher_; // derives the positions of elements
 };
 
 // Method to get the size of the filter
 ContainerSizeType BloomFilter::size() const { return size_; }
 
 // Method to check if a position in the filter is set
-bool BloomFilter::CheckPosition(const ContainerSizeType &pos) { return bit_array_[pos] == 1; }
+bool BloomFilter::CheckPosition(const ContainerSizeType &pos) const { return (words_[pos / 64] >> (pos % 64)) & 1; }
 
-// Method to invert the filter
-void BloomFilter::Invert() { bit_array_.flip(0, size_); }
+// Method to invert the filter, a word at a time
+void BloomFilter::Invert() {
+    for (auto &word: words_) {
+        word = ~word;
+    }
+    if (size_ % 64 != 0) {
+        words_.back() &= (uint64(1) << (size_ % 64)) - 1;
+    }
+}
 
 // Method to clear the filter
-void BloomFilter::Clear() { bit_array_.reset(); }
+void BloomFilter::Clear() { std::fill(words_.begin(), words_.end(), 0); }
+
+// Method to get the number of bits a counter needs to hold counts up to max_count: 4, 8, 16 or 32
+uint32 CounterBits(uint32 max_count);
+
+// Method to get the smallest of the counters of Bits bits at the given positions, counters are packed at
+// Bits-bit offsets into counters. Reads up to three bytes past the last counter.
+uint32 MinCounter(const uint8 *counters, uint32 bits, const ContainerSizeType *positions, uint32 k);
 
-// Class for a counting Bloom filter
+// Class for a counting Bloom filter with counters of Bits bits, 4, 8, 16 or 32. Counters of 4 bits are packed two
+// to a byte. Counts saturate at the largest value of a counter, and saturated counters are no longer decremented.
+template<uint32 Bits>
 class CountBloomFilter {
+    static_assert(Bits == 4 || Bits == 8 || Bits == 16 || Bits == 32, "counters are 4, 8, 16 or 32 bits wide");
+
 public:
     // Delete the default constructor
     CountBloomFilter() = delete;
@@ -66,41 +216,162 @@ public:
     // Default destructor
     ~CountBloomFilter() = default;
 
-    // Constructor that takes the size of the filter and a vector of MurmurHash seeds
-    CountBloomFilter(const ContainerSizeType &size, const std::vector<uint32> &murmurhashSeeds)
-            : size_(size), counter_array_(std::vector<uint32>(size)), murmurhash_seeds_(murmurhashSeeds) {};
+    // Constructor that takes the size of the filter, a vector of MurmurHash seeds, the layout and the size of a block
+    CountBloomFilter(const ContainerSizeType &size, const std::vector<uint32> &murmurhashSeeds,
+                     BloomFilterLayout layout = BloomFilterLayout::seeded, uint32 block_bits = 512)
+            : size_(size), counter_array_((size * Bits + 7) / 8 + counterPadding),
+              hasher_(size, murmurhashSeeds, layout, block_bits) {};
 
     // Method to get the size of the filter
     inline ContainerSizeType size() const;
 
     // Method to insert an element into the filter
-    void Insert(const ElementType &element);
+    inline void Insert(const ElementType &element);
 
     // Method to remove an element from the filter
-    void Remove(const ElementType &element);
+    inline void Remove(const ElementType &element);
 
-    // Method to set the value at a position in the filter
+    // Method to set the value at a position in the filter, values above the largest count saturate
     inline void Set(const ContainerSizeType &position, const uint32 &val);
 
     // Method to check if an element is in the filter
-    uint32 CheckElement(const ElementType &element);
+    inline uint32 CheckElement(const ElementType &element);
+
+    // Method to check if an element is in the filter, from its precomputed positions
+    inline uint32 CheckElement(const ContainerSizeType *positions) const;
 
     // Method to get the value at a position in the filter
-    inline uint32 CheckPosition(const ContainerSizeType &pos);
+    inline uint32 CheckPosition(const ContainerSizeType &pos) const;
+
+    // Largest count a counter holds
+    static constexpr uint32 maxCount = static_cast<uint32>((uint64(1) << Bits) - 1);
 
 private:
-    uint32 size_;
-    std::vector<uint32> counter_array_;
-    std::vector<uint32> murmurhash_seeds_;
+    // Bytes after the last counter, so that every counter can be read as a 32-bit word
+    static constexpr uint32 counterPadding = 3;
+
+    ContainerSizeType size_;
+    std::vector<uint8> counter_array_; // counters packed at Bits-bit offsets
+    BloomFilterHasher hasher_;
 };
 
 // Method to get the size of the filter
-ContainerSizeType CountBloomFilter::size() const { return size_; }
+template<uint32 Bits>
+ContainerSizeType CountBloomFilter<Bits>::size() const { return size_; }
 
 // Method to get the value at a position in the filter
-uint32 CountBloomFilter::CheckPosition(const ContainerSizeType &pos) { return counter_array_[pos]; }
+template<uint32 Bits>
+uint32 CountBloomFilter<Bits>::CheckPosition(const ContainerSizeType &pos) const {
+    uint32 word;
+    std::memcpy(&word, counter_array_.data() + pos * Bits / 8, sizeof(word));
+    return (word >> (pos * Bits % 8)) & maxCount;
+}
+
+// Method to set the value at a position in the filter, values above the largest count saturate
+template<uint32 Bits>
+void CountBloomFilter<Bits>::Set(const ContainerSizeType &position, const uint32 &val) {
+    uint8 *p = counter_array_.data() + position * Bits / 8;
+    uint32 shift = position * Bits % 8;
+    uint32 word;
+    std::memcpy(&word, p, sizeof(word));
+    word = (word & ~(maxCount << shift)) | (std::min(val, maxCount) << shift);
+    std::memcpy(p, &word, sizeof(word));
+}
+
+// Method to insert an element into the counting Bloom filter
+template<uint32 Bits>
+void CountBloomFilter<Bits>::Insert(const ElementType &element) {
+    // Increment the counter at every position of the element
+    hasher_.ForEachPosition(element, [this](ContainerSizeType pos) {
+        uint32 count = CheckPosition(pos);
+        if (count < maxCount) {
+            Set(pos, count + 1);
+        }
+        return true;
+    });
+}
+
+// Method to remove an element from the counting Bloom filter
+template<uint32 Bits>
+void CountBloomFilter<Bits>::Remove(const ElementType &element) {
+    // Decrement the counter at every position of the element, a saturated counter has lost its true count
+    hasher_.ForEachPosition(element, [this](ContainerSizeType pos) {
+        uint32 count = CheckPosition(pos);
+        if (count > 0 && count < maxCount) {
+            Set(pos, count - 1);
+        }
+        return true;
+    });
+}
+
+// Method to check if an element is in the counting Bloom filter
+template<uint32 Bits>
+uint32 CountBloomFilter<Bits>::CheckElement(const ElementType &element) {
+    // Find the minimum value of the counters at the positions of the element
+    uint32 r = INT32_MAX;
+    hasher_.ForEachPosition(element, [this, &r](ContainerSizeType pos) {
+        r = std::min(r, CheckPosition(pos));
+        return true;
+    });
+    return r;
+}
+
+// Method to check if an element is in the counting Bloom filter, from its precomputed positions
+template<uint32 Bits>
+uint32 CountBloomFilter<Bits>::CheckElement(const ContainerSizeType *positions) const {
+    return std::min<uint32>(INT32_MAX, MinCounter(counter_array_.data(), Bits, positions, hasher_.num_hashes()));
+}
+
+// Method to call f with every position of an element, stops early once f returns false
+template<typename F>
+void BloomFilterHasher::ForEachPosition(const ElementType &e, F f) const {
+    uint64 hash[2];
+    if (layout_ == BloomFilterLayout::seeded) {
+        for (auto &seed: murmurhash_seeds_) {
+            MurmurHash3_x86_128(&e, elementTypeWords, seed, hash);
+            if (!f(static_cast<ContainerSizeType>(size_modulo_(hash[0])))) {
+                return;
+            }
+        }
+        return;
+    }
+
+    if constexpr (elementsAreDigests) {
+        std::memcpy(hash, &e, sizeof(hash));
+    } else {
+        // The x86 variant repeats one 32-bit word three times for keys this short, the x64 one fills all 128 bits
+        MurmurHash3_x64_128(&e, elementTypeWords, murmurhash_seeds_[0], hash);
+    }
+    DerivePositions(hash, f);
+}
+
+// Method to call f with every position derived from the 128-bit hash of an element, for the hashed layouts
+template<typename F>
+void BloomFilterHasher::DerivePositions(const uint64 *hash, F f) const {
+    uint32 k = num_hashes();
+    if (layout_ == BloomFilterLayout::hashed) {
+        uint64 h1 = hash[0], h2 = hash[1];
+        for (uint32 i = 0; i < k; i++) {
+            if (!f(static_cast<ContainerSizeType>(FastRange64(h1, size_)))) {
+                return;
+            }
+            h1 += h2;
+            h2 += i;
+        }
+        return;
+    }
 
-// Method to set the value at a position in the filter
-void CountBloomFilter::Set(const ContainerSizeType &position, const uint32 &val) { counter_array_[position] = val; }
+    ContainerSizeType block = FastRange64(hash[0], num_blocks_);
+    ContainerSizeType base = block * block_bits_;
+    auto len = static_cast<uint32>(block + 1 == num_blocks_ ? size_ - base : block_bits_);
+    auto h1 = static_cast<uint32>(hash[1]), h2 = static_cast<uint32>(hash[1] >> 32);
+    for (uint32 i = 0; i < k; i++) {
+        if (!f(base + FastRange32(h1, len))) {
+            return;
+        }
+        h1 += h2;
+        h2 += i;
+    }
+}
 
 #endif // OTMPSI_UTILS_BLOOMFILTER_H_
@@ -0,0 +1,34 @@
+#ifndef OTMPSI_UTILS_PARALLEL_H_
+#define OTMPSI_UTILS_PARALLEL_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+
+// Method to split [0, count) into contiguous ranges of at least min_chunk indices, at most one per thread, and call
+// f(begin, end) for each of them. The calling thread takes the first range, so a single range runs without threads.
+template<typename F>
+inline void ParallelFor(uint64 count, uint32 num_threads, F f, uint64 min_chunk = 1024) {
+    uint64 chunks = std::min<uint64>(std::max<uint32>(num_threads, 1), (count + min_chunk - 1) / min_chunk);
+    if (chunks <= 1) {
+        if (count > 0) {
+            f(uint64(0), count);
+        }
+        return;
+    }
+
+    uint64 step = (count + chunks - 1) / chunks;
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    for (uint64 begin = step; begin < count; begin += step) {
+        threads.emplace_back(f, begin, std::min(count, begin + step));
+    }
+    f(uint64(0), step);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+#endif // OTMPSI_UTILS_PARALLEL_H_
@@ -0,0 +1,55 @@
+#ifndef OTMPSI_UTILS_SETLOADER_H_
+#define OTMPSI_UTILS_SETLOADER_H_
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+// Class for a file mapped read-only into memory
+class MappedFile {
+public:
+    // Delete the default constructor
+    MappedFile() = delete;
+
+    // Constructor that maps the file at path, throws if it cannot be opened
+    explicit MappedFile(const std::string &path);
+
+    // Destructor that unmaps the file
+    ~MappedFile();
+
+    // Delete the copy constructor and the copy assignment
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Method to get the contents of the file
+    [[nodiscard]] inline const char *data() const { return data_; }
+
+    // Method to get the size of the file in bytes
+    [[nodiscard]] inline uint64 size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    uint64 size_ = 0;
+};
+
+// Struct for the statistics of loading a set from a file
+struct SetLoadStatistics {
+    uint64 bytes = 0; // size of the file
+    uint64 records = 0; // elements in the file, duplicates included
+    uint64 elements = 0; // elements of the set
+    double map_seconds = 0; // time to open and map the file
+    double parse_seconds = 0; // time to parse, and digest, the records
+    double deduplicate_seconds = 0; // time to remove the duplicates
+};
+
+// Function to load a set from a file in the given format, parsing and removing duplicates on num_threads threads.
+// The elements end up sorted
+void LoadSet(std::vector<ElementType> &set, const std::string &path, SetFileFormat format, uint32 num_threads,
+             SetLoadStatistics *statistics = nullptr);
+
+// Function to get the set of a party, loaded from the set file of the configuration if there is one and generated
+// otherwise. Loading reports its throughput on the standard output
+void GetElementSet(std::vector<ElementType> &set, const ExperimentConfig &config);
+
+#endif // OTMPSI_UTILS_SETLOADER_H_
@@ -0,0 +1,41 @@
+#ifndef OTMPSI_UTILS_WORKLOAD_H_
+#define OTMPSI_UTILS_WORKLOAD_H_
+
+#include <vector>
+
+#include "common.h"
+
+// Class for generating the set of a party from counters. The elements of an experiment are numbered: every group of
+// parties sharing elements, the common sequence the parties share prefixes of, and every party's own elements get a
+// sequence of counters each, and an element is a keyed bijection of its counter. Elements are therefore distinct by
+// construction, all parties derive the same shared elements from the configuration alone, and any range of a set can
+// be generated independently of the rest. The generator of NTL, which the protocol draws its randomness from, is
+// not touched.
+class WorkloadGenerator {
+public:
+    // Delete the default constructor
+    WorkloadGenerator() = delete;
+
+    // Constructor that takes the experiment configuration of the local party, the key is derived from the same item
+    // seed, so all parties must use the same one
+    explicit WorkloadGenerator(const ExperimentConfig &config);
+
+    // Method to generate the set of the local party on num_threads threads
+    void Generate(std::vector<ElementType> &set, uint32 num_threads) const;
+
+    // Method to get the element at position index of sequence stream
+    [[nodiscard]] ElementType Element(uint64 stream, uint64 index) const;
+
+private:
+    // Struct for a run of elements of one sequence in the set
+    struct Segment {
+        uint64 stream; // sequence the elements are taken from
+        uint64 count; // number of elements, starting at the first of the sequence
+    };
+
+    std::vector<Segment> segments_; // runs the set is made of, in order
+    uint64 stride_; // number of counters of every sequence
+    uint64 key_[2]; // key of the bijection
+};
+
+#endif // OTMPSI_UTILS_WORKLOAD_H_
@@ -3,6 +3,7 @@
 
 #include "protocol/participant.h"
 #include "utils/common.h"
+#include "utils/set_loader.h"
 #include "utils/utils.h"
 #include <chrono>
 #include <thread>
@@ -14,8 +15,8 @@ int main(int argc, char *argv[]) {
     NewConfigFromJsonFile(config, argv[1]);
 
     std::vector<ElementType> set;
-    set.reserve(config.element_set_size);
-    generate_set(set, config);
+    GetElementSet(set, config);
+    SeedRandomGenerator();
 
     assert(config.options.num_parties - config.options.intersection_threshold < config.options.power_q);
 
@@ -0,0 +1,397 @@
+#include "network/shm_endpoint.h"
+
+#include <boost/bind/bind.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "network/tcp_endpoint.h"
+
+// Sleep until the futex word no longer holds the expected value, returns the number of system calls made
+static uint64 FutexWait(std::atomic<uint32> *word, uint32 expected) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32 *>(word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+    return 1;
+#else
+    while (word->load(std::memory_order_acquire) == expected) {
+        std::this_thread::yield();
+    }
+    return 0;
+#endif
+}
+
+// Wake up the process sleeping on the futex word, returns the number of system calls made
+static uint64 FutexWake(std::atomic<uint32> *word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32 *>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// Method to initialize the control block of a freshly created ring
+void ShmRing::Reset() {
+    header_->head.store(0);
+    header_->tail.store(0);
+    header_->data_seq.store(0);
+    header_->reader_waiting.store(0);
+    header_->space_seq.store(0);
+    header_->writer_waiting.store(0);
+}
+
+// Method to copy data into the ring, blocking while it is full, returns the number of futex calls made
+uint64 ShmRing::Write(const void *buf, uint64 len) {
+    uint64 syscalls = 0;
+    auto src = static_cast<const uint8 *>(buf);
+    while (len > 0) {
+        uint64 n = TryWrite(src, len, syscalls);
+        if (n == 0) {
+            syscalls += WaitForSpace(header_->head.load(std::memory_order_relaxed));
+            continue;
+        }
+        src += n;
+        len -= n;
+    }
+    return syscalls;
+}
+
+// Method to copy as much data into the ring as fits without blocking, returns the number of bytes copied
+uint64 ShmRing::TryWrite(const void *buf, uint64 len, uint64 &syscalls) {
+    uint64 head = header_->head.load(std::memory_order_relaxed);
+    uint64 free = shmRingSize - (head - header_->tail.load(std::memory_order_acquire));
+    uint64 n = std::min(free, len);
+    if (n == 0) {
+        return 0;
+    }
+
+    // Copy as much as fits, wrapping around the end of the data area
+    auto src = static_cast<const uint8 *>(buf);
+    uint64 offset = head & (shmRingSize - 1);
+    uint64 first = std::min(n, shmRingSize - offset);
+    std::memcpy(data_ + offset, src, first);
+    std::memcpy(data_, src + first, n - first);
+    header_->head.store(head + n, std::memory_order_release);
+
+    // Wake up the consumer if it went to sleep
+    header_->data_seq.fetch_add(1, std::memory_order_seq_cst);
+    if (header_->reader_waiting.load(std::memory_order_seq_cst)) {
+        syscalls += FutexWake(&header_->data_seq);
+    }
+    return n;
+}
+
+// Method to copy data out of the ring, blocking while it is empty, returns the number of futex calls made
+uint64 ShmRing::Read(void *buf, uint64 len) {
+    uint64 syscalls = 0;
+    auto dst = static_cast<uint8 *>(buf);
+    while (len > 0) {
+        uint64 tail = header_->tail.load(std::memory_order_relaxed);
+        uint64 available = header_->head.load(std::memory_order_acquire) - tail;
+        if (available == 0) {
+            syscalls += WaitForData(tail);
+            continue;
+        }
+
+        // Copy as much as is available, wrapping around the end of the data area
+        uint64 n = std::min(available, len);
+        uint64 offset = tail & (shmRingSize - 1);
+        uint64 first = std::min(n, shmRingSize - offset);
+        std::memcpy(dst, data_ + offset, first);
+        std::memcpy(dst + first, data_, n - first);
+        header_->tail.store(tail + n, std::memory_order_release);
+
+        // Wake up the producer if it went to sleep
+        header_->space_seq.fetch_add(1, std::memory_order_seq_cst);
+        if (header_->writer_waiting.load(std::memory_order_seq_cst)) {
+            syscalls += FutexWake(&header_->space_seq);
+        }
+
+        dst += n;
+        len -= n;
+    }
+    return syscalls;
+}
+
+// Method to block until the consumer has released space, returns the number of futex calls made
+uint64 ShmRing::WaitForSpace(uint64 head) {
+    for (int i = 0; i < shmSpinLimit; i++) {
+        if (head - header_->tail.load(std::memory_order_acquire) < shmRingSize) {
+            return 0;
+        }
+    }
+    uint64 syscalls = 0;
+    header_->writer_waiting.store(1, std::memory_order_seq_cst);
+    uint32 seq = header_->space_seq.load(std::memory_order_seq_cst);
+    if (head - header_->tail.load(std::memory_order_acquire) == shmRingSize) {
+        syscalls = FutexWait(&header_->space_seq, seq);
+    }
+    header_->writer_waiting.store(0, std::memory_order_relaxed);
+    return syscalls;
+}
+
+// Method to block until the producer has written data, returns the number of futex calls made
+uint64 ShmRing::WaitForData(uint64 tail) {
+    for (int i = 0; i < shmSpinLimit; i++) {
+        if (header_->head.load(std::memory_order_acquire) != tail) {
+            return 0;
+        }
+    }
+    uint64 syscalls = 0;
+    header_->reader_waiting.store(1, std::memory_order_seq_cst);
+    uint32 seq = header_->data_seq.load(std::memory_order_seq_cst);
+    if (header_->head.load(std::memory_order_acquire) == tail) {
+        syscalls = FutexWait(&header_->data_seq, seq);
+    }
+    header_->reader_waiting.store(0, std::memory_order_relaxed);
+    return syscalls;
+}
+
+// Locate the two rings of a segment, the creator writes to the first one and reads from the second one
+static ShmRing RingAt(void *segment, int index) {
+    auto base = static_cast<uint8 *>(segment) + index * (sizeof(ShmRingHeader) + shmRingSize);
+    return {reinterpret_cast<ShmRingHeader *>(base), base + sizeof(ShmRingHeader)};
+}
+
+// Constructor that maps the segment and picks the ring directions depending on which side created it
+ShmChannel::ShmChannel(void *segment, bool is_creator)
+        : segment_(segment), out_(RingAt(segment, is_creator ? 0 : 1)), in_(RingAt(segment, is_creator ? 1 : 0)) {
+    if (is_creator) {
+        out_.Reset();
+        in_.Reset();
+    }
+}
+
+// Destructor that waits until the queued data is in the ring, joins the sender thread and unmaps the segment
+ShmChannel::~ShmChannel() {
+    if (sender_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        sender_.join();
+    }
+    munmap(segment_, SegmentSize());
+}
+
+// Method to copy data into the ring or queue what does not fit, taking ownership of data if owned is set
+uint64 ShmChannel::Send(const uint8 *data, uint32 len, bool owned) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint64 syscalls = 0;
+    uint32 offset = 0;
+
+    // Only write to the ring directly if nothing is queued before this message, the sender thread is then idle
+    if (queue_.empty()) {
+        offset = out_.TryWrite(data, len, syscalls);
+    }
+
+    // Queue whatever the ring has no room for, and let the sender thread write it as the remote reads
+    if (offset < len) {
+        if (owned) {
+            queue_.push_back({const_cast<uint8 *>(data), len, offset});
+        } else {
+            auto copy = static_cast<uint8 *>(malloc(len - offset));
+            std::memcpy(copy, data + offset, len - offset);
+            queue_.push_back({copy, len - offset, 0});
+        }
+        if (!sender_.joinable()) {
+            sender_ = std::thread(&ShmChannel::SendLoop, this);
+        }
+        cv_.notify_all();
+    } else if (owned) {
+        free(const_cast<uint8 *>(data));
+    }
+    return syscalls;
+}
+
+// Loop of the sender thread
+void ShmChannel::SendLoop() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        auto message = queue_.front();
+        lock.unlock();
+
+        out_.Write(message.data + message.offset, message.len - message.offset);
+        free(message.data);
+
+        lock.lock();
+        queue_.pop_front();
+    }
+}
+
+// Open (and create, if requested) a shared-memory segment and map it
+static void *MapSegment(const std::string &segment_name, bool create) {
+    int fd = shm_open(segment_name.c_str(), create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open " + segment_name + ": " + std::strerror(errno));
+    }
+    if (create && ftruncate(fd, ShmChannel::SegmentSize()) != 0) {
+        close(fd);
+        shm_unlink(segment_name.c_str());
+        throw std::runtime_error("ftruncate " + segment_name + ": " + std::strerror(errno));
+    }
+    void *segment = mmap(nullptr, ShmChannel::SegmentSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        throw std::runtime_error("mmap " + segment_name + ": " + std::strerror(errno));
+    }
+    return segment;
+}
+
+// Method to start the endpoint
+void ShmEndpoint::Start() {
+    tg_.create_thread(boost::bind(&ShmEndpoint::StartHandler, this));
+}
+
+// Method to stop the endpoint
+void ShmEndpoint::Stop() {
+    StopListen();
+    for (const auto &remote: GetRemoteNames()) {
+        CloseChannel(remote);
+    }
+    io_service_.stop();
+    tg_.join_all();
+}
+
+// Method to stop listen
+void ShmEndpoint::StopListen() {
+    accept_flag_ = false;
+    acceptor_.close();
+}
+
+// Handler for starting the endpoint
+void ShmEndpoint::StartHandler() {
+    accept_flag_ = true;
+    StartAccept();
+    io_service_.run();
+}
+
+// Method to start accepting incoming connection requests
+void ShmEndpoint::StartAccept() {
+    auto socket = std::make_shared<tcp::socket>(io_service_);
+    acceptor_.async_accept(*socket, boost::bind(&ShmEndpoint::AcceptHandler, this, socket,
+                                                boost::asio::placeholders::error));
+}
+
+// Handler for accepting incoming connection requests. The connecting side sends its name and the name of the
+// segment it created, and waits for an acknowledgement before unlinking the segment.
+void ShmEndpoint::AcceptHandler(const std::shared_ptr<tcp::socket> &socket, const boost::system::error_code &error) {
+    if (!accept_flag_) {
+        return;
+    }
+    if (error) {
+        std::cerr << "Error accepting connection: " << error.message() << std::endl;
+    } else {
+        // A failure is reported like a failed accept and the socket is closed without an acknowledgement, so the
+        // connecting side fails instead of the io thread
+        try {
+            char remote_name[nameSizeLimit];
+            char segment_name[nameSizeLimit];
+            boost::asio::read(*socket, boost::asio::buffer(remote_name, nameSizeLimit));
+            boost::asio::read(*socket, boost::asio::buffer(segment_name, nameSizeLimit));
+
+            auto new_channel = std::make_unique<ShmChannel>(MapSegment(segment_name, false), false);
+            {
+                std::lock_guard<std::mutex> lock(channels_mtx_);
+                channels_.insert(std::make_pair(std::string(remote_name), std::move(new_channel)));
+            }
+
+            uint8 ack = 1;
+            boost::asio::write(*socket, boost::asio::buffer(&ack, sizeof(ack)));
+        } catch (const std::exception &e) {
+            std::cerr << "Error accepting connection: " << e.what() << std::endl;
+        }
+    }
+    StartAccept();
+}
+
+// Method to connect to a remote endpoint
+void
+ShmEndpoint::Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) {
+    static std::atomic<uint32> segment_counter(0);
+
+    // Create a segment with a name unique to this process and channel
+    std::string segment_name = "/otmpsi_" + std::to_string(getpid()) + "_" + std::to_string(segment_counter++);
+    auto new_channel = std::make_unique<ShmChannel>(MapSegment(segment_name, true), true);
+
+    // Hand the segment over to the remote endpoint
+    tcp::socket socket(io_service_);
+    ConnectSocket(socket, resolver_, remote_address);
+    char buffer[nameSizeLimit] = {0};
+    local_name.copy(buffer, nameSizeLimit - 1);
+    boost::asio::write(socket, boost::asio::buffer(buffer, nameSizeLimit));
+    std::memset(buffer, 0, nameSizeLimit);
+    segment_name.copy(buffer, nameSizeLimit - 1);
+    boost::asio::write(socket, boost::asio::buffer(buffer, nameSizeLimit));
+
+    // Both sides have the segment mapped once the remote acknowledges, so the name can be removed
+    uint8 ack;
+    boost::system::error_code error;
+    boost::asio::read(socket, boost::asio::buffer(&ack, sizeof(ack)), error);
+    shm_unlink(segment_name.c_str());
+    if (error) {
+        throw std::runtime_error("connect to " + remote_name + ": the segment was not mapped: " + error.message());
+    }
+
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    channels_.insert(std::make_pair(remote_name, std::move(new_channel)));
+}
+
+// Method to close a connection with a remote endpoint
+void ShmEndpoint::CloseChannel(const std::string &remote_name) {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    channels_.erase(remote_name);
+}
+
+// Method to look up the channel of a remote endpoint
+ShmChannel &ShmEndpoint::channel(const std::string &remote_name) {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    return *channels_.at(remote_name);
+}
+
+// Method to write data to a remote endpoint
+void ShmEndpoint::Write(const std::string &remote_name, const void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    auto syscalls = channel(remote_name).Write(buf, len);
+    stats_.RecordWrite(remote_name, len, syscalls, start);
+}
+
+// Method to asynchronously write data to a remote endpoint, the buffer is freed once written
+void ShmEndpoint::AsyncWrite(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    auto syscalls = channel(remote_name).AsyncWrite(buf, len);
+    stats_.RecordWrite(remote_name, len, syscalls, start);
+}
+
+// Method to read data from a remote endpoint
+void ShmEndpoint::Read(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    auto syscalls = channel(remote_name).Read(buf, len);
+    stats_.RecordRead(remote_name, len, syscalls, start);
+}
+
+// Method to get the names of all connected remote endpoints
+std::vector<std::string> ShmEndpoint::GetRemoteNames() {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    std::vector<std::string> remotes;
+    remotes.reserve(channels_.size());
+    for (const auto &channel: channels_) {
+        remotes.push_back(channel.first);
+    }
+    return remotes;
+}
\ No newline at end of file
@@ -0,0 +1,461 @@
+#include "network/uring_endpoint.h"
+
+#ifdef OTMPSI_HAVE_IO_URING
+
+#include <boost/bind/bind.hpp>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "network/tcp_endpoint.h"
+
+// Kinds of operations, stored in the top byte of the user data of a submission
+const uint64 uringSendKind = 1;
+const uint64 uringReceiveKind = 2;
+
+// Encode the kind of an operation and the index of its buffer into the user data of a submission
+static uint64 UserData(uint64 kind, int index) { return kind << 56 | static_cast<uint64>(index); }
+
+// Throw the error of a failed system call
+static void ThrowErrno(const std::string &what) {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Constructor that sets up a ring with the given number of entries and maps its queues
+UringQueue::UringQueue(uint32 entries) {
+    io_uring_params params{};
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+        ThrowErrno("io_uring_setup");
+    }
+
+    // Map the submission and completion rings, which share one mapping on recent kernels
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        close(fd_);
+        ThrowErrno("mmap io_uring submission ring");
+    }
+    cq_ring_ = single_mmap ? sq_ring_ : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                             fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+        munmap(sq_ring_, sq_ring_size_);
+        close(fd_);
+        ThrowErrno("mmap io_uring completion ring");
+    }
+    sq_entries_ = params.sq_entries;
+    sqes_ = static_cast<io_uring_sqe *>(mmap(nullptr, sq_entries_ * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+        if (cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        munmap(sq_ring_, sq_ring_size_);
+        close(fd_);
+        ThrowErrno("mmap io_uring submission entries");
+    }
+
+    auto sq = static_cast<uint8 *>(sq_ring_);
+    sq_head_ = reinterpret_cast<uint32 *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<uint32 *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<uint32 *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<uint32 *>(sq + params.sq_off.array);
+    auto cq = static_cast<uint8 *>(cq_ring_);
+    cq_head_ = reinterpret_cast<uint32 *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<uint32 *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<uint32 *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    local_tail_ = *sq_tail_;
+}
+
+// Destructor that unmaps the queues and closes the ring
+UringQueue::~UringQueue() {
+    munmap(sqes_, sq_entries_ * sizeof(io_uring_sqe));
+    if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(fd_);
+}
+
+// Method to get a cleared submission entry, submitting queued entries first if the queue is full
+io_uring_sqe *UringQueue::GetSqe() {
+    if (local_tail_ - std::atomic_ref<uint32>(*sq_head_).load(std::memory_order_acquire) == sq_entries_) {
+        Submit(0);
+    }
+    uint32 index = local_tail_ & *sq_mask_;
+    sq_array_[index] = index;
+    local_tail_++;
+    to_submit_++;
+    std::memset(&sqes_[index], 0, sizeof(io_uring_sqe));
+    return &sqes_[index];
+}
+
+// Method to submit all queued entries and wait for at least wait_nr completions, in a single system call
+void UringQueue::Submit(uint32 wait_nr) {
+    if (to_submit_ == 0 && wait_nr == 0) {
+        return;
+    }
+    std::atomic_ref<uint32>(*sq_tail_).store(local_tail_, std::memory_order_release);
+    uint32 flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        syscalls_++;
+        auto ret = syscall(__NR_io_uring_enter, fd_, to_submit_, wait_nr, flags, nullptr, 0);
+        if (ret >= 0) {
+            to_submit_ -= ret;
+            return;
+        }
+        if (errno != EINTR) {
+            ThrowErrno("io_uring_enter");
+        }
+    }
+}
+
+// Method to take the next completion, returns false if none is available
+bool UringQueue::PeekCqe(io_uring_cqe &cqe) {
+    uint32 head = *cq_head_;
+    if (head == std::atomic_ref<uint32>(*cq_tail_).load(std::memory_order_acquire)) {
+        return false;
+    }
+    cqe = cqes_[head & *cq_mask_];
+    std::atomic_ref<uint32>(*cq_head_).store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// Method to wait for and take the next completion
+void UringQueue::WaitCqe(io_uring_cqe &cqe) {
+    while (!PeekCqe(cqe)) {
+        Submit(1);
+    }
+}
+
+// Method to register buffers for fixed reads and writes, returns false if the kernel refuses to pin them
+bool UringQueue::RegisterBuffers(const std::vector<iovec> &buffers) {
+    return syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers.data(), buffers.size()) == 0;
+}
+
+// Method to check whether the kernel supports an operation
+bool UringQueue::Supports(uint8 opcode) {
+    const uint32 numOps = 256;
+    std::vector<uint8> memory(sizeof(io_uring_probe) + numOps * sizeof(io_uring_probe_op), 0);
+    auto probe = reinterpret_cast<io_uring_probe *>(memory.data());
+    if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, numOps) != 0) {
+        return false;
+    }
+    return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+}
+
+// Constructor that takes the port number used to accept connections and the zero-copy threshold
+UringEndpoint::UringEndpoint(int port, uint32 zero_copy_threshold)
+        : acceptor_(io_service_, tcp::endpoint(tcp::v4(), port)), resolver_(io_service_), ring_(uringQueueDepth),
+          zero_copy_threshold_(zero_copy_threshold) {
+    void *memory = mmap(nullptr, uringBufferCount * uringBufferSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        ThrowErrno("mmap io_uring send buffers");
+    }
+    buffer_memory_ = static_cast<uint8 *>(memory);
+
+    std::vector<iovec> iovecs;
+    for (uint32 i = 0; i < uringBufferCount; i++) {
+        buffers_.push_back({buffer_memory_ + i * uringBufferSize});
+        iovecs.push_back({buffers_.back().data, uringBufferSize});
+        free_buffers_.push_back(i);
+    }
+
+    // Without registered buffers every send pins its pages, which is slower but still correct
+    fixed_buffers_ = ring_.RegisterBuffers(iovecs);
+    zero_copy_supported_ = zero_copy_threshold_ > 0 && ring_.Supports(IORING_OP_SEND_ZC);
+}
+
+// Destructor that releases the registered buffers
+UringEndpoint::~UringEndpoint() {
+    munmap(buffer_memory_, uringBufferCount * uringBufferSize);
+}
+
+// Method to start the endpoint
+void UringEndpoint::Start() {
+    tg_.create_thread(boost::bind(&UringEndpoint::StartHandler, this));
+}
+
+// Method to stop the endpoint
+void UringEndpoint::Stop() {
+    StopListen();
+    for (const auto &remote: GetRemoteNames()) {
+        CloseChannel(remote);
+    }
+    io_service_.stop();
+    tg_.join_all();
+}
+
+// Method to stop listen
+void UringEndpoint::StopListen() {
+    accept_flag_ = false;
+    acceptor_.close();
+}
+
+// Handler for starting the endpoint
+void UringEndpoint::StartHandler() {
+    accept_flag_ = true;
+    StartAccept();
+    io_service_.run();
+}
+
+// Method to start accepting incoming connection requests
+void UringEndpoint::StartAccept() {
+    auto socket = std::make_shared<tcp::socket>(io_service_);
+    acceptor_.async_accept(*socket, boost::bind(&UringEndpoint::AcceptHandler, this, socket,
+                                                boost::asio::placeholders::error));
+}
+
+// Handler for accepting incoming connection requests
+void UringEndpoint::AcceptHandler(const std::shared_ptr<tcp::socket> &socket, const boost::system::error_code &error) {
+    if (!accept_flag_) {
+        return;
+    }
+    if (error) {
+        std::cerr << "Error accepting connection: " << error.message() << std::endl;
+    } else {
+        char remote_name[nameSizeLimit];
+        boost::asio::read(*socket, boost::asio::buffer(remote_name, nameSizeLimit));
+        AddChannel(remote_name, std::move(*socket));
+    }
+    StartAccept();
+}
+
+// Method to connect to a remote endpoint
+void
+UringEndpoint::Connect(const std::string &remote_name, const std::string &remote_address,
+                       const std::string &local_name) {
+    tcp::socket socket(io_service_);
+    ConnectSocket(socket, resolver_, remote_address);
+    char buffer[nameSizeLimit] = {0};
+    local_name.copy(buffer, nameSizeLimit - 1);
+    boost::asio::write(socket, boost::asio::buffer(buffer, nameSizeLimit));
+    AddChannel(remote_name, std::move(socket));
+}
+
+// Method to add a connected socket under a remote name
+void UringEndpoint::AddChannel(const std::string &remote_name, tcp::socket socket) {
+    // Writes are already coalesced here, so Nagle's algorithm would only delay the last segment of a message
+    socket.set_option(tcp::no_delay(true));
+    auto new_channel = std::make_unique<Channel>(std::move(socket));
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    channels_.insert(std::make_pair(remote_name, std::move(new_channel)));
+}
+
+// Method to close a connection with a remote endpoint
+void UringEndpoint::CloseChannel(const std::string &remote_name) {
+    std::lock_guard<std::mutex> io_lock(io_mtx_);
+    Drain();
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    channels_.erase(remote_name);
+}
+
+// Method to look up the channel of a remote endpoint
+UringEndpoint::Channel &UringEndpoint::channel(const std::string &remote_name) {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    return *channels_.at(remote_name);
+}
+
+// Method to take a free registered buffer, reaping completions until one is released
+int UringEndpoint::AcquireBuffer() {
+    while (free_buffers_.empty()) {
+        io_uring_cqe cqe{};
+        ring_.WaitCqe(cqe);
+        Complete(cqe);
+    }
+    int index = free_buffers_.back();
+    free_buffers_.pop_back();
+    return index;
+}
+
+// Method to start sending the next queued buffer of a channel, one at a time to keep the stream in order
+void UringEndpoint::SendNext(Channel &channel) {
+    if (channel.queued.empty()) {
+        return;
+    }
+    int index = channel.queued.front();
+    channel.queued.pop_front();
+    channel.sending = true;
+    PrepareSend(index);
+}
+
+// Method to queue a send of the unsent part of a buffer
+void UringEndpoint::PrepareSend(int index) {
+    auto &buffer = buffers_[index];
+    auto sqe = ring_.GetSqe();
+    sqe->fd = buffer.channel->socket.native_handle();
+    sqe->addr = reinterpret_cast<uint64>(buffer.data + buffer.sent);
+    sqe->len = buffer.len - buffer.sent;
+    sqe->user_data = UserData(uringSendKind, index);
+    if (zero_copy_supported_ && buffer.len >= zero_copy_threshold_) {
+        sqe->opcode = IORING_OP_SEND_ZC;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        if (fixed_buffers_) {
+            sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+            sqe->buf_index = index;
+        }
+    } else if (fixed_buffers_) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->buf_index = index;
+    } else {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->msg_flags = MSG_NOSIGNAL;
+    }
+}
+
+// Method to return a buffer to the free list once it is sent and the kernel no longer references it
+void UringEndpoint::ReleaseIfDone(int index) {
+    auto &buffer = buffers_[index];
+    if (buffer.sent < buffer.len || buffer.notifications > 0) {
+        return;
+    }
+    buffer.channel = nullptr;
+    buffer.len = 0;
+    buffer.sent = 0;
+    free_buffers_.push_back(index);
+}
+
+// Method to handle a completion
+void UringEndpoint::Complete(const io_uring_cqe &cqe) {
+    auto kind = cqe.user_data >> 56;
+    auto index = static_cast<int>(cqe.user_data & ((1ULL << 56) - 1));
+    if (kind == uringReceiveKind) {
+        receive_result_ = cqe.res;
+        receive_done_ = true;
+        return;
+    }
+
+    // A zero-copy send completes twice, the second time once the kernel no longer reads from the buffer
+    auto &buffer = buffers_[index];
+    if (cqe.flags & IORING_CQE_F_NOTIF) {
+        buffer.notifications--;
+        ReleaseIfDone(index);
+        return;
+    }
+    if (cqe.flags & IORING_CQE_F_MORE) {
+        buffer.notifications++;
+    }
+    if (cqe.res <= 0) {
+        throw std::runtime_error(std::string("io_uring send: ") + std::strerror(cqe.res < 0 ? -cqe.res : EPIPE));
+    }
+
+    // Resubmit the rest of a short send, otherwise move on to the next buffer of the channel
+    buffer.sent += cqe.res;
+    if (buffer.sent < buffer.len) {
+        PrepareSend(index);
+        return;
+    }
+    auto &channel = *buffer.channel;
+    channel.sending = false;
+    SendNext(channel);
+    ReleaseIfDone(index);
+}
+
+// Method to wait until no send is in flight
+void UringEndpoint::Drain() {
+    while (free_buffers_.size() < uringBufferCount) {
+        io_uring_cqe cqe{};
+        ring_.WaitCqe(cqe);
+        Complete(cqe);
+    }
+}
+
+// Method to write data to a remote endpoint
+void UringEndpoint::Write(const std::string &remote_name, const void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    std::lock_guard<std::mutex> lock(io_mtx_);
+    auto syscalls = ring_.syscalls();
+    auto &ch = channel(remote_name);
+    auto src = static_cast<const uint8 *>(buf);
+    uint32 left = len;
+    while (left > 0) {
+        int index = AcquireBuffer();
+        auto &buffer = buffers_[index];
+        buffer.len = std::min(left, uringBufferSize);
+        buffer.channel = &ch;
+        std::memcpy(buffer.data, src, buffer.len);
+        src += buffer.len;
+        left -= buffer.len;
+        ch.queued.push_back(index);
+        if (!ch.sending) {
+            SendNext(ch);
+        }
+    }
+
+    // All data has to be on its way before returning, as the caller may not come back to the endpoint for a while
+    while (!ch.queued.empty()) {
+        io_uring_cqe cqe{};
+        ring_.WaitCqe(cqe);
+        Complete(cqe);
+    }
+    ring_.Submit(0);
+    stats_.RecordWrite(remote_name, len, ring_.syscalls() - syscalls, start);
+}
+
+// Method to asynchronously write data to a remote endpoint, the buffer is freed once copied
+void UringEndpoint::AsyncWrite(const std::string &remote_name, void *buf, uint32 len) {
+    Write(remote_name, buf, len);
+    free(buf);
+}
+
+// Method to read data from a remote endpoint
+void UringEndpoint::Read(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    std::lock_guard<std::mutex> lock(io_mtx_);
+    auto syscalls = ring_.syscalls();
+    int fd = channel(remote_name).socket.native_handle();
+    auto dst = static_cast<uint8 *>(buf);
+    uint32 left = len;
+    while (left > 0) {
+        auto sqe = ring_.GetSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64>(dst);
+        sqe->len = left;
+        sqe->msg_flags = MSG_WAITALL;
+        sqe->user_data = UserData(uringReceiveKind, 0);
+
+        // Sends still in flight complete while waiting for the receive
+        receive_done_ = false;
+        while (!receive_done_) {
+            io_uring_cqe cqe{};
+            ring_.WaitCqe(cqe);
+            Complete(cqe);
+        }
+        if (receive_result_ <= 0) {
+            throw std::runtime_error("io_uring receive from " + remote_name + ": " +
+                                     (receive_result_ == 0 ? "connection closed" : std::strerror(-receive_result_)));
+        }
+        dst += receive_result_;
+        left -= receive_result_;
+    }
+    stats_.RecordRead(remote_name, len, ring_.syscalls() - syscalls, start);
+}
+
+// Method to get the names of all connected remote endpoints
+std::vector<std::string> UringEndpoint::GetRemoteNames() {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
+    std::vector<std::string> remotes;
+    remotes.reserve(channels_.size());
+    for (const auto &channel: channels_) {
+        remotes.push_back(channel.first);
+    }
+    return remotes;
+}
+
+#endif // OTMPSI_HAVE_IO_URING
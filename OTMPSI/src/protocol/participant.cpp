@@ -1,6 +1,9 @@
 #include "protocol/participant.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
 #include <thread>
 
 const std::string serverName = "server";
@@ -15,7 +18,9 @@ void Participant::Initialize() {
         InitializeServer();
     }
 
+    endpoint_->SetPhase("DKG");
     DistributedKeyGeneration();
+    endpoint_->SetPhase(setupPhaseName);
 }
 
 // Initialize the client participant
@@ -28,9 +33,7 @@ void Participant::InitializeClient() {
 
     // Wait for all connections to be established
     uint32 numConn = 3;
-    while (endpoint_->GetRemoteNames().size() < numConn) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-    }
+    endpoint_->WaitForConnections(numConn);
     endpoint_->StopListen();
 }
 
@@ -41,9 +44,7 @@ void Participant::InitializeServer() {
 
     // Wait for all connections to be established
     uint32 numConn = options_.num_parties + 1;
-    while (endpoint_->GetRemoteNames().size() < numConn) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-    }
+    endpoint_->WaitForConnections(numConn);
     endpoint_->StopListen();
 }
 
@@ -93,24 +94,31 @@ std::vector<long long> Participant::Execute(bool print) {
     std::vector<Ciphertext> encrypted_bases(
             size); // encrypted bases that will be passed along the ring for the purpose of voting
     std::vector<NTL::ZZ> decrypted_bases(size); // decryption outputs
-    std::vector<std::pair<int, uint64>> result; // OTMPSI final result
+    std::vector<std::pair<int, ElementType>> result; // OTMPSI final result
     std::vector<Ciphertext> rerand_array(
             options_.bloom_filter_size); // probabilistic encryption of 1, used for ReRand Algorithm
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    endpoint_->SetPhase("Prepare");
     Prepare(encrypted_bases, rerand_array);
+    endpoint_->SetPhase("RingLatency");
     RingLatency(false);
 
     auto preparation_done = std::chrono::high_resolution_clock::now();
 
+    endpoint_->SetPhase("RingPass");
     RingPass(encrypted_bases, rerand_array);
 
+    endpoint_->SetPhase("Decrypt");
     Decrypt(decrypted_bases, encrypted_bases, rerand_array);
 
+    endpoint_->SetPhase("FindIntersection");
     FindIntersection(result, decrypted_bases);
 
     auto end = std::chrono::high_resolution_clock::now();
+    endpoint_->SetPhase(setupPhaseName);
+    WriteStatistics();
 
     auto preparation = std::chrono::duration_cast<std::chrono::milliseconds>(preparation_done - start).count();
     auto online = std::chrono::duration_cast<std::chrono::milliseconds>(end - preparation_done).count();
@@ -122,6 +130,17 @@ std::vector<long long> Participant::Execute(bool print) {
     return durations;
 }
 
+// Write the traffic statistics of the endpoint to the configured file, if any
+void Participant::WriteStatistics() const {
+    if (options_.statistics_output.empty()) {
+        return;
+    }
+    nlohmann::json statistics = {{"party",  options_.local_name},
+                                 {"phases", endpoint_->GetStatistics()}};
+    std::ofstream file(options_.statistics_output);
+    file << statistics.dump(4) << std::endl;
+}
+
 // Check if a number is a generator
 bool is_generator(const NTL::ZZ &g, const NTL::ZZ &p, const std::vector<NTL::ZZ> &ppFactors) {
     NTL::ZZ temp;
@@ -136,10 +155,11 @@ bool is_generator(const NTL::ZZ &g, const NTL::ZZ &p, const std::vector<NTL::ZZ>
 
 // Prepare for the protocol
 void Participant::Prepare(std::vector<Ciphertext> &encrypted_bases, std::vector<Ciphertext> &rerand_array) {
-    // Build the bloom filter
-    for (const auto &e: elements_) {
-        bf_.Insert(e);
+    // Build the bloom filter, hashing the elements only if the set has changed
+    if (!positions_.computed()) {
+        positions_.Compute(bf_.hasher(), elements_, options_.num_threads);
     }
+    bf_.InsertAll(positions_, options_.num_threads);
 
     // Invert bloom filter
     bf_.Invert();
@@ -202,37 +222,45 @@ void Participant::RingPass(std::vector<Ciphertext> &encrypted_bases, const std::
     }
 }
 
-// Pass the bases on the ring for the server participant
+// Pass the bases on the ring for the server participant, in batches of batch_size ciphertexts
 void Participant::RingPassServer(std::vector<Ciphertext> &encrypted_bases) {
-    for (const auto &base: encrypted_bases) {
+    ContainerSizeType size = bf_.size();
+    for (ContainerSizeType i = 0; i < size; i += options_.batch_size) {
         // if head, send ciphertexts to right neighbor to start
-        SendCiphertext(rightNeighborName, base);
+        SendCiphertexts(rightNeighborName, &encrypted_bases[i],
+                        std::min<ContainerSizeType>(options_.batch_size, size - i));
     }
 
-    for (auto i = 0; i < bf_.size(); i++) {
+    for (ContainerSizeType i = 0; i < size; i += options_.batch_size) {
         // receive from left neighbor to end this stage
-        ReceiveCiphertext(leftNeighborName, encrypted_bases[i]);
+        ReceiveCiphertexts(leftNeighborName, &encrypted_bases[i],
+                           std::min<ContainerSizeType>(options_.batch_size, size - i));
     }
 }
 
-// Pass the bases on the ring for the client participant
+// Pass the bases on the ring for the client participant, a batch is forwarded as soon as it is processed
 void
 Participant::RingPassClient(std::vector<Ciphertext> &encrypted_bases, const std::vector<Ciphertext> &rerand_array) {
-    Ciphertext temp;
-    for (auto i = 0; i < bf_.size(); i++) {
+    std::vector<Ciphertext> batch(options_.batch_size);
+    ContainerSizeType size = bf_.size();
+    for (ContainerSizeType i = 0; i < size; i += options_.batch_size) {
+        auto count = std::min<ContainerSizeType>(options_.batch_size, size - i);
+
         // receive from left neighbor
-        ReceiveCiphertext(leftNeighborName, temp);
+        ReceiveCiphertexts(leftNeighborName, batch.data(), count);
 
-        // raise to Power of q if it is a 1 in node's rbf
-        if (bf_.CheckPosition(i)) {
-            Power(temp, temp, options_.q);
-        }
+        for (ContainerSizeType j = 0; j < count; j++) {
+            // raise to Power of q if it is a 1 in node's rbf
+            if (bf_.CheckPosition(i + j)) {
+                Power(batch[j], batch[j], options_.q);
+            }
 
-        // ReRand c
-        Mul(temp, temp, rerand_array[i]);
+            // ReRand c
+            Mul(batch[j], batch[j], rerand_array[i + j]);
+        }
 
         // send to right neighbor
-        SendCiphertext(rightNeighborName, temp);
+        SendCiphertexts(rightNeighborName, batch.data(), count);
     }
 }
 
@@ -283,7 +311,7 @@ void Participant::DecryptClient() {
 }
 
 // Find the intersection of the sets
-void Participant::FindIntersection(std::vector<std::pair<int, uint64>> &intersection,
+void Participant::FindIntersection(std::vector<std::pair<int, ElementType>> &intersection,
                                    const std::vector<NTL::ZZ> &decrypted_bases) {
     if (role() == Role::server) {
         FindIntersectionServer(intersection, decrypted_bases);
@@ -291,11 +319,32 @@ void Participant::FindIntersection(std::vector<std::pair<int, uint64>> &intersec
 }
 
 // Find the intersection of the sets for the server participant
-void Participant::FindIntersectionServer(std::vector<std::pair<int, uint64>> &intersection,
+void Participant::FindIntersectionServer(std::vector<std::pair<int, ElementType>> &intersection,
+                                         const std::vector<NTL::ZZ> &decrypted_bases) {
+    // A position gets at most one vote per party, so the counters only need to hold the number of parties
+    switch (CounterBits(options_.num_parties)) {
+        case 4:
+            FindIntersectionServer<4>(intersection, decrypted_bases);
+            break;
+        case 8:
+            FindIntersectionServer<8>(intersection, decrypted_bases);
+            break;
+        case 16:
+            FindIntersectionServer<16>(intersection, decrypted_bases);
+            break;
+        default:
+            FindIntersectionServer<32>(intersection, decrypted_bases);
+    }
+}
+
+// Find the intersection of the sets for the server participant, counting votes in counters of CounterBits bits
+template<uint32 CounterBits>
+void Participant::FindIntersectionServer(std::vector<std::pair<int, ElementType>> &intersection,
                                          const std::vector<NTL::ZZ> &decrypted_bases) {
     int cnt;
     NTL::ZZ temp;
-    CountBloomFilter rcbf(options_.bloom_filter_size, options_.murmurhash_seeds);
+    CountBloomFilter<CounterBits> rcbf(options_.bloom_filter_size, options_.murmurhash_seeds,
+                                       options_.bloom_filter_layout, options_.bloom_filter_block_bits);
 
     // fill in the rcbf using the decrypted values
     for (auto i = 0; i < decrypted_bases.size(); i++) {
@@ -314,10 +363,10 @@ void Participant::FindIntersectionServer(std::vector<std::pair<int, uint64>> &in
 
     // perform membership tests using the rcbf
     int num;
-    for (const auto &e: elements_) {
-        num = rcbf.CheckElement(e);
+    for (uint64 i = 0; i < elements_.size(); i++) {
+        num = rcbf.CheckElement(positions_.row(i));
         if (num > 0) {
-            intersection.emplace_back(num, e);
+            intersection.emplace_back(num, elements_[i]);
         }
     }
 }
@@ -405,6 +454,56 @@ void Participant::CollectZz(std::vector<NTL::ZZ> &zz_array) {
     }
 }
 
+// Send a batch of ciphertexts to a remote participant in one message
+void Participant::SendCiphertexts(const std::string &remote, const Ciphertext *ciphertexts, uint64 count) {
+    // Leave room for the length of a packed batch in front of the numbers
+    wire_buffer_.resize(sizeof(uint32) + codec_.MaxEncodedSize(2 * count));
+    uint8 *end = wire_buffer_.data() + sizeof(uint32);
+    for (uint64 i = 0; i < count; i++) {
+        end = codec_.EncodeNext(end, ciphertexts[i].first);
+        end = codec_.EncodeNext(end, ciphertexts[i].second);
+    }
+    SendBatch(remote, end);
+}
+
+// Receive a batch of ciphertexts from a remote participant in one message
+void Participant::ReceiveCiphertexts(const std::string &remote, Ciphertext *ciphertexts, uint64 count) {
+    const uint8 *buf = ReceiveBatch(remote, 2 * count);
+    for (uint64 i = 0; i < count; i++) {
+        buf = codec_.DecodeNext(ciphertexts[i].first, buf);
+        buf = codec_.DecodeNext(ciphertexts[i].second, buf);
+    }
+}
+
+// Send the batch encoded into the wire buffer up to end. A packed batch is preceded by its length, a fixed one is
+// the same on the wire as its numbers sent one by one.
+void Participant::SendBatch(const std::string &remote, const uint8 *end) {
+    auto len = static_cast<uint32>(end - wire_buffer_.data() - sizeof(uint32));
+    if (codec_.format() == ZzFormat::packed) {
+        std::memcpy(wire_buffer_.data(), &len, sizeof(len));
+        endpoint_->Write(remote, wire_buffer_.data(), sizeof(len) + len);
+    } else {
+        endpoint_->Write(remote, wire_buffer_.data() + sizeof(len), len);
+    }
+}
+
+// Receive a batch of count numbers into the wire buffer, returns the start of the encoded numbers
+const uint8 *Participant::ReceiveBatch(const std::string &remote, uint64 count) {
+    auto len = static_cast<uint32>(codec_.MaxEncodedSize(count));
+    if (codec_.format() == ZzFormat::packed) {
+        uint32 packed_len;
+        endpoint_->Read(remote, &packed_len, sizeof(packed_len));
+        if (packed_len > len) {
+            throw std::length_error("packed batch of " + std::to_string(packed_len) + " bytes from " + remote +
+                                    " exceeds " + std::to_string(len) + " bytes");
+        }
+        len = packed_len;
+    }
+    wire_buffer_.resize(len);
+    endpoint_->Read(remote, wire_buffer_.data(), len);
+    return wire_buffer_.data();
+}
+
 // Broadcast a ciphertext to all remote participants
 void Participant::BroadcastCiphertext(const Ciphertext &ciphertext) {
     for (const auto &remote: options_.party_list) {
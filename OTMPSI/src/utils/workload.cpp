@@ -0,0 +1,128 @@
+#include "utils/workload.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "utils/parallel.h"
+
+namespace {
+
+// Function to step a SplitMix64 state and return its next output, for deriving keys from a seed
+uint64 SplitMix64(uint64 &state) {
+    uint64 z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function for a keyed bijection on 32-bit words: two rounds of the lowbias32 finalizer, keyed by xor before each
+uint32 Permute32(uint32 x, uint64 key) {
+    for (uint32 round = 0; round < 2; round++) {
+        x ^= static_cast<uint32>(key >> (32 * round));
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+    }
+    return x;
+}
+
+// Function for a keyed bijection on 64-bit words: the SplitMix64 finalizer, keyed by adding the key before it
+uint64 Permute64(uint64 x, uint64 key) {
+    x += key;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+// Constructor that takes the experiment configuration of the local party
+WorkloadGenerator::WorkloadGenerator(const ExperimentConfig &config) : stride_(config.element_set_size) {
+    const auto &parties = config.options.party_list;
+    auto it = std::find(parties.begin(), parties.end(), config.options.local_name);
+    if (it == parties.end()) {
+        throw std::invalid_argument(config.options.local_name + " is not one of allParties");
+    }
+    uint64 party = it - parties.begin();
+
+    // Groups come first, then the common sequence, then the own elements of every party
+    uint64 groups = config.shared_elements.size();
+    uint64 shared = 0;
+    if (groups > 0) {
+        for (uint64 g = 0; g < groups; g++) {
+            const auto &group = config.shared_elements[g];
+            if (group.count > stride_) {
+                throw std::invalid_argument("a group shares more elements than setSize");
+            }
+            if (std::find(group.parties.begin(), group.parties.end(), config.options.local_name) !=
+                group.parties.end()) {
+                segments_.push_back({g, group.count});
+                shared += group.count;
+            }
+        }
+    } else {
+        shared = std::min(config.num_same_items, config.element_set_size);
+        segments_.push_back({groups, shared});
+    }
+    if (shared > config.element_set_size) {
+        throw std::invalid_argument(config.options.local_name + " shares more elements than setSize");
+    }
+    segments_.push_back({groups + 1 + party, config.element_set_size - shared});
+
+    // 32-bit elements have room for 2^32 counters only
+    uint64 streams = groups + 1 + parties.size();
+    if (sizeof(ElementType) == sizeof(uint32) && stride_ > 0 && streams > (uint64(1) << 32) / stride_) {
+        throw std::invalid_argument("the workload needs more distinct elements than 32-bit elements can hold");
+    }
+
+    uint64 state = config.same_item_seed;
+    key_[0] = SplitMix64(state);
+    key_[1] = SplitMix64(state);
+}
+
+// Method to get the element at position index of sequence stream
+ElementType WorkloadGenerator::Element(uint64 stream, uint64 index) const {
+    uint64 counter = stream * stride_ + index;
+    ElementType e;
+    if constexpr (sizeof(ElementType) == sizeof(uint32)) {
+        uint32 word = Permute32(static_cast<uint32>(counter), key_[0]);
+        std::memcpy(&e, &word, sizeof(e));
+    } else {
+        // The first word alone keeps the elements distinct, the others fill the element
+        uint64 words[sizeof(ElementType) / sizeof(uint64)];
+        for (uint64 i = 0; i < sizeof(ElementType) / sizeof(uint64); i++) {
+            words[i] = Permute64(counter, key_[i % 2] + i);
+        }
+        std::memcpy(&e, words, sizeof(e));
+    }
+    return e;
+}
+
+// Method to generate the set of the local party on num_threads threads
+void WorkloadGenerator::Generate(std::vector<ElementType> &set, uint32 num_threads) const {
+    uint64 size = 0;
+    for (const auto &segment: segments_) {
+        size += segment.count;
+    }
+    set.resize(size);
+
+    ParallelFor(size, num_threads, [&](uint64 begin, uint64 end) {
+        // Find the segment of the first position, then walk the segments along the range
+        uint64 s = 0, segment_begin = 0;
+        while (segment_begin + segments_[s].count <= begin) {
+            segment_begin += segments_[s].count;
+            s++;
+        }
+        for (uint64 i = begin; i < end; i++) {
+            while (i - segment_begin >= segments_[s].count) {
+                segment_begin += segments_[s].count;
+                s++;
+            }
+            set[i] = Element(segments_[s].stream, i - segment_begin);
+        }
+    }, 1 << 14);
+}
@@ -0,0 +1,103 @@
+#include "utils/zz_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Limbs hold whole bytes in little-endian order, and can be copied as they are, with GMP limbs on a little-endian host
+#if defined(NTL_ZZ_NBITS) && NTL_ZZ_NBITS % 8 == 0 && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define OTMPSI_ZZ_CODEC_LIMBS 1
+static_assert(NTL_ZZ_NBITS == 8 * sizeof(NTL::ZZ_limb_t), "limbs must not have nail bits");
+#endif
+
+// Copy the low bytes of a number to dst, at most max_bytes, returns the number of significant bytes copied
+static uint32 CopyBytes(uint8 *dst, const NTL::ZZ &n, uint32 max_bytes) {
+#ifdef OTMPSI_ZZ_CODEC_LIMBS
+    auto bytes = static_cast<uint32>(std::min<uint64>(n.size() * sizeof(NTL::ZZ_limb_t), max_bytes));
+    if (bytes > 0) {
+        std::memcpy(dst, NTL::ZZ_limbs_get(n), bytes);
+    }
+    // The top limb is only partly used
+    while (bytes > 0 && dst[bytes - 1] == 0) {
+        bytes--;
+    }
+    return bytes;
+#else
+    auto bytes = static_cast<uint32>(std::min<long>(NTL::NumBytes(n), max_bytes));
+    NTL::BytesFromZZ(dst, n, bytes);
+    return bytes;
+#endif
+}
+
+// Set a number from its little-endian bytes, reusing the storage it owns
+static void SetBytes(NTL::ZZ &n, const uint8 *src, uint32 bytes) {
+#ifdef OTMPSI_ZZ_CODEC_LIMBS
+    // The wire buffer is not aligned for limbs, so the bytes go through a scratch array first
+    thread_local std::vector<NTL::ZZ_limb_t> scratch;
+    uint32 limbs = (bytes + sizeof(NTL::ZZ_limb_t) - 1) / sizeof(NTL::ZZ_limb_t);
+    if (scratch.size() < limbs) {
+        scratch.resize(limbs);
+    }
+    if (limbs > 0) {
+        scratch[limbs - 1] = 0;
+        std::memcpy(scratch.data(), src, bytes);
+    }
+    NTL::ZZ_limbs_set(n, scratch.data(), limbs);
+#else
+    NTL::ZZFromBytes(n, src, bytes);
+#endif
+}
+
+// Constructor that takes the width of a number in bytes and the wire format
+ZzCodec::ZzCodec(uint32 width, ZzFormat format) : width_(width), format_(format) {
+    if (format_ == ZzFormat::packed && width_ >= (1 << (8 * packedLengthBytes))) {
+        throw std::invalid_argument("numbers of " + std::to_string(width_) + " bytes are too wide to be packed");
+    }
+}
+
+// Method to encode a number at buf, returns the position after it
+uint8 *ZzCodec::EncodeNext(uint8 *buf, const NTL::ZZ &n) const {
+    if (format_ == ZzFormat::fixed) {
+        uint32 bytes = CopyBytes(buf, n, width_);
+        std::memset(buf + bytes, 0, width_ - bytes);
+        return buf + width_;
+    }
+    uint32 bytes = CopyBytes(buf + packedLengthBytes, n, width_);
+    buf[0] = bytes & 0xff;
+    buf[1] = bytes >> 8;
+    return buf + packedLengthBytes + bytes;
+}
+
+// Method to decode a number at buf into n, returns the position after it
+const uint8 *ZzCodec::DecodeNext(NTL::ZZ &n, const uint8 *buf) const {
+    if (format_ == ZzFormat::fixed) {
+        SetBytes(n, buf, width_);
+        return buf + width_;
+    }
+    uint32 bytes = buf[0] | (static_cast<uint32>(buf[1]) << 8);
+    if (bytes > width_) {
+        throw std::length_error("packed number of " + std::to_string(bytes) + " bytes exceeds the width");
+    }
+    SetBytes(n, buf + packedLengthBytes, bytes);
+    return buf + packedLengthBytes + bytes;
+}
+
+// Method to encode count numbers into buf, returns the number of bytes written
+uint64 ZzCodec::Encode(uint8 *buf, const NTL::ZZ *numbers, uint64 count) const {
+    uint8 *end = buf;
+    for (uint64 i = 0; i < count; i++) {
+        end = EncodeNext(end, numbers[i]);
+    }
+    return end - buf;
+}
+
+// Method to decode count numbers from buf, returns the number of bytes read
+uint64 ZzCodec::Decode(NTL::ZZ *numbers, const uint8 *buf, uint64 count) const {
+    const uint8 *end = buf;
+    for (uint64 i = 0; i < count; i++) {
+        end = DecodeNext(numbers[i], end);
+    }
+    return end - buf;
+}
@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# Run the parties over shared memory on a set large enough that the ring pass puts more data in flight than the
+# rings of all channels hold: with the default arguments the Bloom filter has about 7700 positions of two numbers of
+# about 300 bytes each, some 4.6 MB against 1 MiB per ring. The run must complete rather than deadlock.
+
+# Set the desired values for the set_size argument and the number of parties
+set_size=${1:-160}
+number_of_parties=${2:-3}
+intersection_threshold=${3:-2}
+
+# Generate the configuration files for a single round over shared memory
+python3 ./tools/gen_config/gen_config.py --no_print --transport shm --benchmark_rounds 1 --false_positive_rate 0.00001 \
+    --set_size "$set_size" --number_of_parties "$number_of_parties" --intersection_threshold "$intersection_threshold"
+
+# Run the clients in the background and the server in the foreground, which prints the results
+for i in $(seq 2 "$number_of_parties"); do
+    ./bin/main "./config/P${i}_config.json" > /dev/null &
+done
+./bin/main ./config/P1_config.json
+wait
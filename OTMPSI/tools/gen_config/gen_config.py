@@ -62,6 +62,114 @@ parser.add_argument(
 parser.add_argument("-q", "--q", type=int, help="The q value", default=2)
 parser.add_argument("--q_power", type=int, help="The power of q", default=56)
 
+parser.add_argument(
+    "--transport",
+    choices=["tcp", "uring", "shm"],
+    help="The transport between parties, uring is TCP through io_uring, shm requires all parties on the same host",
+    default="tcp"
+)
+parser.add_argument(
+    "--bloom_filter_layout",
+    choices=["seeded", "hashed", "blocked"],
+    help="How the positions of an element in the Bloom filter are derived, hashed and blocked hash an element once",
+    default="seeded"
+)
+parser.add_argument(
+    "--bloom_filter_block_bits",
+    type=int,
+    help="The size of a block of the blocked Bloom filter layout",
+    default=512
+)
+parser.add_argument(
+    "--num_threads",
+    type=int,
+    help="The number of threads each party uses where the protocol runs in parallel, 0 for one per hardware thread",
+    default=0
+)
+parser.add_argument(
+    "--zz_format",
+    choices=["fixed", "packed"],
+    help="The wire format of batches of numbers, packed drops leading zero bytes",
+    default="fixed"
+)
+parser.add_argument(
+    "--batch_size",
+    type=int,
+    help="The number of values sent in one message where the protocol sends them in batches",
+    default=256
+)
+parser.add_argument(
+    "--tcp_streams",
+    type=int,
+    help="The number of parallel TCP connections per channel, data is striped across them",
+    default=1
+)
+parser.add_argument(
+    "--tcp_stripe_bytes",
+    type=int,
+    help="The number of bytes sent on one TCP connection before moving to the next",
+    default=2**16
+)
+parser.add_argument(
+    "--tcp_send_buffer_bytes",
+    type=int,
+    help="The send buffer size of every TCP connection, 0 keeps the kernel's autotuning",
+    default=0
+)
+parser.add_argument(
+    "--tcp_receive_buffer_bytes",
+    type=int,
+    help="The receive buffer size of every TCP connection, 0 keeps the kernel's autotuning",
+    default=0
+)
+parser.add_argument("--tcp_no_delay", action="store_true", help="Disable Nagle's algorithm on TCP connections")
+parser.add_argument("--tcp_quick_ack", action="store_true", help="Acknowledge TCP segments without delay")
+parser.add_argument(
+    "--latency_ms",
+    type=float,
+    help="The emulated one-way latency of every link in milliseconds",
+    default=0
+)
+parser.add_argument(
+    "--jitter_ms",
+    type=float,
+    help="The emulated jitter of every link in milliseconds",
+    default=0
+)
+parser.add_argument(
+    "--bandwidth_mbps",
+    type=float,
+    help="The emulated bandwidth of every link in Mbit/s, 0 for no cap",
+    default=0
+)
+parser.add_argument(
+    "--statistics_dir",
+    type=str,
+    help="The directory each party writes its traffic statistics to after every execution",
+    default=""
+)
+parser.add_argument(
+    "--set_dir",
+    type=str,
+    help="The directory each party loads its set from instead of generating it",
+    default=""
+)
+parser.add_argument(
+    "--set_file_format",
+    type=str,
+    choices=["binary", "numbers", "identifiers"],
+    help="The format of the set files",
+    default="numbers"
+)
+parser.add_argument(
+    "--shared",
+    type=str,
+    action="append",
+    help="A group of parties and the number of elements all of them share, e.g. P1,P2,P3:100. Repeat for more "
+         "groups; the parties then fill their sets with elements of their own instead of sharing prefixes",
+    default=[]
+)
+
 # Argument to control whether or not to print the values of the arguments
 parser.add_argument("--no_print", action="store_true", help="Do not print to output")
 
@@ -167,18 +275,25 @@ config = {
     "bloomFilterSize": bloom_filter_size,
     "sameNum": args.set_size,
     "sameSeed": same_seed,
-    "diffSeed": 0,
+    "sharedElements": [{"parties": group.split(":")[0].split(","), "count": int(group.split(":")[1])}
+                       for group in args.shared],
     "numberOfParties": args.number_of_parties,
     "threshold": args.intersection_threshold,
     "benchmarkRounds": args.benchmark_rounds,
     "numberOfHashFunctions": number_of_hash_functions,
     "murmurhashSeeds": murmurhash_seeds,
+    "bloomFilterLayout": args.bloom_filter_layout,
+    "bloomFilterBlockBits": args.bloom_filter_block_bits,
+    "numThreads": args.num_threads,
     "isServer": False,
     "port": 20081,
     "localName": "",
     "serverAddress": "",
     "rightNeighborAddress": "",
     "allParties": party_list,
+    "transport": args.transport,
+    "zzFormat": args.zz_format,
+    "batchSize": args.batch_size,
     "p": str(args.p),
     "phiPPrimeFactors": pp_list,
     "q": str(args.q),
@@ -187,20 +302,34 @@ config = {
     "bufferSize": buffer_size
 }
 
+# tune the TCP channels if any option differs from the defaults
+if (args.tcp_streams != 1 or args.tcp_stripe_bytes != 2**16 or args.tcp_send_buffer_bytes > 0
+        or args.tcp_receive_buffer_bytes > 0 or args.tcp_no_delay or args.tcp_quick_ack):
+    config["tcp"] = {
+        "streams": args.tcp_streams,
+        "stripeBytes": args.tcp_stripe_bytes,
+        "sendBufferBytes": args.tcp_send_buffer_bytes,
+        "receiveBufferBytes": args.tcp_receive_buffer_bytes,
+        "noDelay": args.tcp_no_delay,
+        "quickAck": args.tcp_quick_ack
+    }
+
+# emulate a wide area network between the parties if any link parameter is set
+if args.latency_ms > 0 or args.jitter_ms > 0 or args.bandwidth_mbps > 0:
+    config["networkEmulation"] = {
+        "latencyMs": args.latency_ms,
+        "jitterMs": args.jitter_ms,
+        "bandwidthMbps": args.bandwidth_mbps
+    }
+
 # clean the dir
 dir = './config'
 for f in os.listdir(dir):
     os.remove(os.path.join(dir, f))
 
 # compose the config JSON and write to file
-diffSeeds = []
 for i in range(1, args.number_of_parties + 1):
     config["sameNum"] = max([args.set_size - (i - 1) * diff_step, same_amount])
-    diffSeed = random.randint(2, INT_MAX)
-    while (diffSeed in diffSeeds):
-        diffSeed = random.randint(2, INT_MAX)
-    config["diffSeed"] = diffSeed
-    diffSeeds += [diffSeed]
 
     if i == 1:
         config["isServer"] = True
@@ -209,6 +338,12 @@ for i in range(1, args.number_of_parties + 1):
 
     config["port"] = args.server_port + i - 1
     config["localName"] = "P" + str(i)
+    if args.statistics_dir:
+        config["statisticsOutput"] = os.path.join(args.statistics_dir, "P" + str(i) + "_statistics.json")
+    if args.set_dir:
+        extension = ".bin" if args.set_file_format == "binary" else ".txt"
+        config["setFile"] = os.path.abspath(os.path.join(args.set_dir, "P" + str(i) + "_set" + extension))
+        config["setFileFormat"] = args.set_file_format
     config["serverAddress"] = "127.0.0.1:" + str(args.server_port)
     config["rightNeighborAddress"] = "127.0.0.1:" + \
                                      str(args.server_port + (i) % (args.number_of_parties))
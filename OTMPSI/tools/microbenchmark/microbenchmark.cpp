@@ -0,0 +1,26 @@
+#include "microbenchmark.h"
+
+#include <functional>
+#include <iostream>
+#include <map>
+
+// Runs one of the microbenchmarks of the building blocks of the protocol.
+// Usage: microbenchmark <benchmark> [options]
+int main(int argc, char *argv[]) {
+    const std::map<std::string, std::function<int(const std::vector<std::string> &)>> benchmarks = {
+            {"bloom", BloomBenchmark},
+            {"codec", CodecBenchmark},
+            {"hash", HashBenchmark},
+    };
+
+    auto it = argc > 1 ? benchmarks.find(argv[1]) : benchmarks.end();
+    if (it == benchmarks.end()) {
+        std::cerr << "Usage: " << argv[0] << " <benchmark> [options], benchmarks:";
+        for (const auto &benchmark: benchmarks) {
+            std::cerr << " " << benchmark.first;
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+    return it->second(std::vector<std::string>(argv + 2, argv + argc));
+}
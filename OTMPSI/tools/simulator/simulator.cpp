@@ -0,0 +1,145 @@
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "network/emulated_endpoint.h"
+#include "network/memory_endpoint.h"
+#include "protocol/participant.h"
+#include "utils/common.h"
+#include "utils/set_loader.h"
+#include "utils/utils.h"
+
+// Runs all parties of an experiment as threads of one process, connected through in-memory endpoints.
+// Usage: simulator [--deterministic] [--seed <seed>] <config of each party>...
+int main(int argc, char *argv[]) {
+    bool deterministic = false;
+    long seed = (long) time(nullptr);
+    std::vector<std::string> config_files;
+    for (auto i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--deterministic") == 0) {
+            deterministic = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::stol(argv[++i]);
+        } else {
+            config_files.emplace_back(argv[i]);
+        }
+    }
+
+    std::vector<ExperimentConfig> configs(config_files.size());
+    for (uint32 i = 0; i < config_files.size(); i++) {
+        NewConfigFromJsonFile(configs[i], config_files[i]);
+    }
+    if (configs.empty() || configs.size() != configs[0].options.party_list.size()) {
+        std::cerr << "Usage: " << argv[0] << " [--deterministic] [--seed <seed>] <config of each party>..."
+                  << std::endl;
+        return 1;
+    }
+
+    // Order the parties as listed in the configs, so that the schedule does not depend on the argument order
+    const auto &party_list = configs[0].options.party_list;
+    auto position = [&](const ExperimentConfig &config) {
+        return std::find(party_list.begin(), party_list.end(), config.options.local_name) - party_list.begin();
+    };
+    std::sort(configs.begin(), configs.end(), [&](const ExperimentConfig &a, const ExperimentConfig &b) {
+        return position(a) < position(b);
+    });
+
+    // Emulated links deliver from their own sender threads, which the deterministic schedule does not control
+    bool emulated = configs[0].options.network_emulation.enabled;
+    if (deterministic && emulated) {
+        std::cerr << "--deterministic cannot be combined with network emulation" << std::endl;
+        return 1;
+    }
+
+    MemoryNetwork network(deterministic);
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+    std::vector<uint32> ids;
+    for (const auto &config: configs) {
+        auto endpoint = new MemoryEndpoint(network, config.options.port);
+        ids.push_back(endpoint->id());
+        if (emulated) {
+            endpoints.emplace_back(new EmulatedEndpoint(endpoint, config.options.network_emulation,
+                                                        config.options.local_name));
+        } else {
+            endpoints.emplace_back(endpoint);
+        }
+    }
+
+    std::vector<std::vector<long long>> durations(configs.size());
+    std::vector<uint64> bytes_sent(configs.size());
+    std::vector<uint64> bytes_received(configs.size());
+    std::vector<size_t> set_sizes(configs.size());
+    std::vector<std::thread> threads;
+    for (uint32 i = 0; i < configs.size(); i++) {
+        threads.emplace_back([&, i] {
+            const auto &config = configs[i];
+            auto id = ids[i];
+            try {
+                network.Enter(id);
+
+                std::vector<ElementType> set;
+                GetElementSet(set, config);
+                set_sizes[i] = set.size();
+
+                // The random generator of NTL is per thread, give each party its own reproducible stream
+                if (deterministic) {
+                    NTL::SetSeed(NTL::conv<NTL::ZZ>(seed + i));
+                } else {
+                    SeedRandomGenerator();
+                }
+
+                assert(config.options.num_parties - config.options.intersection_threshold < config.options.power_q);
+
+                bool is_server = config.options.role == Role::server;
+                Participant participant(config.options, set, endpoints[i].get());
+                participant.Initialize();
+                participant.RingLatency(false);
+                participant.RingLatency(is_server);
+                durations[i] = participant.Execute(is_server);
+                participant.Stop();
+
+                bytes_sent[i] = participant.GetTotalBytesSent();
+                bytes_received[i] = participant.GetTotalBytesReceived();
+            } catch (...) {
+                // Record the failure, which also wakes the other parties so that they unwind
+                network.Fail(std::current_exception());
+            }
+            network.Leave(id);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    if (auto failure = network.failure()) {
+        std::rethrow_exception(failure);
+    }
+
+    for (uint32 i = 0; i < configs.size(); i++) {
+        const auto &options = configs[i].options;
+        std::stringstream ss;
+        if (options.role == Role::server) {
+            ss << "-----------------------------------\n"
+               << std::left << std::setw(26) << "Number of parties: " << options.num_parties << "\n"
+               << std::left << std::setw(26) << "Intersection threshold: " << options.intersection_threshold << "\n"
+               << std::left << std::setw(26) << "Set size: " << set_sizes[i] << "\n"
+               << "-----------------------------------\n"
+               << std::left << std::setw(26) << "Total execution time: " << (durations[i][0] + durations[i][1])
+               << "ms \n"
+               << std::left << std::setw(26) << "Preparation time: " << durations[i][0] << "ms \n"
+               << std::left << std::setw(26) << "Online time: " << durations[i][1] << "ms \n"
+               << std::left << std::setw(26) << "Server data sent: " << FormatBytes(bytes_sent[i]) << " \n"
+               << std::left << std::setw(26) << "Server data received: " << FormatBytes(bytes_received[i]);
+            std::cout << ss.str() << std::endl;
+        } else if (options.local_name == "P2") {
+            ss << std::left << std::setw(26) << "Client data sent: " << FormatBytes(bytes_sent[i]) << " \n"
+               << std::left << std::setw(26) << "Client data received: " << FormatBytes(bytes_received[i]) << " \n";
+            std::cout << ss.str() << std::endl;
+        }
+    }
+
+    return 0;
+}
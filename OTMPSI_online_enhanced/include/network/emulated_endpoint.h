@@ -0,0 +1,129 @@
+#ifndef OTMPSI_NETWORK_EMULATEDENDPOINT_H_
+#define OTMPSI_NETWORK_EMULATEDENDPOINT_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "endpoint.h"
+
+// Class for the sending side of an emulated link. Messages are queued with the time they would reach the remote
+// over a link with the configured latency, jitter and bandwidth, and a sender thread hands them to the wrapped
+// endpoint once that time has come.
+class EmulatedLink {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Delete the default constructor
+    EmulatedLink() = delete;
+
+    // Constructor that takes the wrapped endpoint, the remote name and the link parameters
+    EmulatedLink(Endpoint *inner, std::string remote_name, const LinkEmulation &emulation, uint64 buffer_bytes,
+                 uint64 seed);
+
+    // Destructor that drains the queue and joins the sender thread
+    ~EmulatedLink();
+
+    // Method to queue a message, takes ownership of buf and blocks while the send buffer is full
+    void Send(void *buf, uint32 len);
+
+private:
+    // A message waiting for its delivery time
+    struct Message {
+        void *data;
+        uint32 len;
+        Clock::time_point deliver_at;
+    };
+
+    // Loop of the sender thread
+    void SendLoop();
+
+    Endpoint *inner_;
+    std::string remote_name_;
+    LinkEmulation emulation_;
+    uint64 buffer_bytes_;
+    std::mt19937_64 rng_; // source of the jitter
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Message> queue_;
+    uint64 queued_bytes_ = 0;
+    Clock::time_point wire_free_at_; // time at which the last queued message has been serialized
+    Clock::time_point last_deliver_at_; // delivery time of the last queued message, keeps the link FIFO
+    bool stopping_ = false;
+    std::thread sender_;
+};
+
+// Class for an endpoint that emulates a wide area network on top of another endpoint. Latency, jitter and
+// bandwidth are applied in user space on the sending side of every link, so both directions of a channel are
+// shaped by the endpoint that writes to it. Traffic is counted here, as the protocol sees it, rather than by the
+// wrapped endpoint.
+class EmulatedEndpoint : public Endpoint {
+public:
+    // Delete the default constructor
+    EmulatedEndpoint() = delete;
+
+    // Constructor that takes ownership of the wrapped endpoint
+    EmulatedEndpoint(Endpoint *inner, const NetworkEmulation &emulation, std::string local_name)
+            : inner_(inner), emulation_(emulation), local_name_(std::move(local_name)) {};
+
+    // Destructor that drains all links
+    ~EmulatedEndpoint() override = default;
+
+    // Method to start the endpoint
+    void Start() override { inner_->Start(); };
+
+    // Method to stop the endpoint, once all queued messages have been delivered
+    void Stop() override;
+
+    // Method to stop listen
+    void StopListen() override { inner_->StopListen(); };
+
+    // Method to connect to a remote endpoint
+    inline void
+    Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) override;
+
+    // Method to block until at least num_connections remote endpoints are connected
+    void WaitForConnections(uint32 num_connections) override { inner_->WaitForConnections(num_connections); };
+
+    // Method to close a connection with a remote endpoint, once all queued messages have been delivered
+    void CloseChannel(const std::string &remote_name) override;
+
+    // Method to write data to a remote endpoint
+    void Write(const std::string &remote_name, const void *buf, uint32 len) override;
+
+    // Method to asynchronously write data to a remote endpoint, the buffer is freed once delivered
+    void AsyncWrite(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to read data from a remote endpoint
+    void Read(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to get the names of all connected remote endpoints
+    std::vector<std::string> GetRemoteNames() override { return inner_->GetRemoteNames(); };
+
+private:
+    // Method to get the link to a remote endpoint, creating it on first use
+    EmulatedLink &link(const std::string &remote_name);
+
+    // links_ is declared after inner_ so that the links are drained before the wrapped endpoint is destroyed
+    std::unique_ptr<Endpoint> inner_;
+    NetworkEmulation emulation_;
+    std::string local_name_;
+    std::mutex links_mtx_;
+    std::unordered_map<std::string, std::unique_ptr<EmulatedLink>> links_;
+};
+
+// Method to connect to a remote endpoint
+void EmulatedEndpoint::Connect(const std::string &remote_name, const std::string &remote_address,
+                               const std::string &local_name) {
+    inner_->Connect(remote_name, remote_address, local_name);
+}
+
+#endif // OTMPSI_NETWORK_EMULATEDENDPOINT_H_
@@ -3,6 +3,8 @@
 
 #include <NTL/ZZ.h>
 
+#include <compare>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -13,18 +15,41 @@ typedef unsigned char uint8; // 8 bit unsigned integer
 typedef unsigned int uint32; // 32 bit unsigned integer
 typedef unsigned long uint64; // 64 bit unsigned integer
 
+// Struct for a 128-bit element, the digest of an identifier of any length such as an email address or a UUID
+struct Element128 {
+    uint64 lo; // first 64 bits of the digest
+    uint64 hi; // last 64 bits of the digest
+
+    auto operator<=>(const Element128 &) const = default;
+};
+
+// Define the width of the elements in the set in bits, 32, 64 or 128. It is fixed at build time (make ELEMENT_BITS=64)
+// and all parties must use the same width
+#ifndef OTMPSI_ELEMENT_BITS
+#define OTMPSI_ELEMENT_BITS 32
+#endif
+
 // Define the type of elements in the set
+#if OTMPSI_ELEMENT_BITS == 32
 typedef uint32 ElementType;
+#elif OTMPSI_ELEMENT_BITS == 64
+typedef uint64 ElementType;
+#elif OTMPSI_ELEMENT_BITS == 128
+typedef Element128 ElementType;
+#else
+#error "OTMPSI_ELEMENT_BITS must be 32, 64 or 128"
+#endif
 // Define the type of container sizes
 typedef uint32 ContainerSizeType;
 
-// Define the maximum value for the element type
-const ElementType elementTypeMax = UINT32_MAX;
 // Define the maximum value for the container size type
 const ContainerSizeType containerSizeTypeMax = UINT32_MAX;
 
-// Define the number of words in an element type
-const int elementTypeWords = 4;
+// Define the number of bytes in an element type
+const int elementTypeWords = sizeof(ElementType);
+
+// Define whether elements are uniformly distributed digests, whose bits the Bloom filter takes as their hash
+constexpr bool elementsAreDigests = OTMPSI_ELEMENT_BITS == 128;
 
 // Enum for the role of a party in the protocol
 enum Role {
@@ -32,6 +57,52 @@ enum Role {
     server = 1,
 };
 
+// Enum for the wire format of batches of numbers
+enum class ZzFormat {
+    fixed = 0, // every number takes the same number of bytes
+    packed = 1, // every number is prefixed with its length, leading zero bytes are dropped
+};
+
+// Enum for how the positions of an element in a Bloom filter are derived
+enum class BloomFilterLayout {
+    seeded = 0, // one hash per seed, each reduced modulo the size of the filter
+    hashed = 1, // all positions derived from one 128-bit hash by double hashing
+    blocked = 2, // as hashed, but all positions of an element fall into one block of the filter
+};
+
+// Enum for the format of a set file
+enum class SetFileFormat {
+    binary = 0, // elements one after another as they are laid out in memory, little endian
+    numbers = 1, // one decimal number per line
+    identifiers = 2, // one identifier per line, e.g. an email address, hashed to an element with DigestElement
+};
+
+// Struct for storing the parameters of an emulated network link
+struct LinkEmulation {
+    double latency_ms = 0; // one-way latency
+    double jitter_ms = 0; // maximum deviation from the latency, drawn uniformly
+    double bandwidth_mbps = 0; // bandwidth cap, 0 for no cap
+};
+
+// Struct for storing the network emulation options
+struct NetworkEmulation {
+    bool enabled = false; // wrap the endpoint into an emulated network
+    LinkEmulation link; // parameters of every link
+    std::map<std::string, LinkEmulation> links; // parameters overridden per remote name
+    uint64 buffer_bytes = 1 << 22; // bytes a link queues before writes block
+    uint64 seed = 0; // seed of the jitter
+};
+
+// Struct for storing the options of TCP channels
+struct TcpOptions {
+    uint32 streams = 1; // parallel TCP connections per channel, data is striped across them
+    uint32 stripe_bytes = 1 << 16; // bytes sent on one connection before moving to the next
+    int send_buffer_bytes = 0; // SO_SNDBUF of every connection, 0 keeps the kernel's autotuning
+    int receive_buffer_bytes = 0; // SO_RCVBUF of every connection, 0 keeps the kernel's autotuning
+    bool no_delay = false; // disable Nagle's algorithm
+    bool quick_ack = false; // acknowledge immediately instead of delaying, re-armed after every receive
+};
+
 // Struct for storing options for the protocol
 struct Options {
     uint32 num_parties; // number of parties
@@ -41,6 +112,9 @@ struct Options {
     std::vector<uint32> murmurhash_seeds; // murmurhash seeds
 
     ContainerSizeType bloom_filter_size; // size of Bloom Filter.
+    BloomFilterLayout bloom_filter_layout; // how the positions of an element are derived
+    uint32 bloom_filter_block_bits; // size of a block of the blocked layout
+    uint32 num_threads; // threads for the parts of the protocol that run in parallel
 
     Role role; // client or server
     uint32 port; // server listening port
@@ -49,6 +123,13 @@ struct Options {
     std::string right_neighbor_address; // address of right neighbor on the ring
     std::vector<std::string> party_list; // all parties' name
     uint32 num_bytes_field_numbers; // number of bytes for numbers belongs to prime field p_
+    std::string transport; // transport between parties, "tcp", "uring" for TCP through io_uring, or "shm"
+    uint32 uring_zero_copy_threshold; // smallest send the io_uring transport makes without copying, 0 disables
+    TcpOptions tcp; // streams and socket options of TCP channels
+    ZzFormat zz_format; // wire format of batches of numbers
+    uint32 batch_size; // number of values sent in one message where the protocol sends them in batches
+    NetworkEmulation network_emulation; // emulated latency, jitter and bandwidth of the links
+    std::string statistics_output; // file the traffic statistics are written to after every execution, if set
 
     NTL::ZZ p; // large prime p_, 1024 bits. p_-1 also needs to have large prime factor
     NTL::ZZ q; // small prime q.
@@ -58,13 +139,22 @@ struct Options {
     std::vector<NTL::ZZ> phi_p_prime_factor_list; // phi(p_) factors
 };
 
+// Struct for a group of parties that share elements
+struct SharedElements {
+    std::vector<std::string> parties; // names of the parties sharing the elements
+    ContainerSizeType count; // number of elements all of them hold
+};
+
 // Struct for storing experiment configuration
 struct ExperimentConfig {
     ContainerSizeType element_set_size;
     ContainerSizeType num_same_items;
     uint32 same_item_seed;
-    uint32 diff_item_seed;
     uint32 benchmark_rounds;
+    std::vector<SharedElements> shared_elements; // groups sharing elements, if empty the parties share prefixes of
+                                                 // one common sequence, num_same_items long
+    std::string set_file; // file the set is loaded from, the set is generated if empty
+    SetFileFormat set_file_format; // format of the set file
 
     Options options;
 };
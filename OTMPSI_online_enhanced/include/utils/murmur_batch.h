@@ -0,0 +1,29 @@
+#ifndef OTMPSI_UTILS_MURMURBATCH_H_
+#define OTMPSI_UTILS_MURMURBATCH_H_
+
+#include "common.h"
+
+// Enum for the instruction sets of the batch hash kernels
+enum class HashKernel {
+    scalar = 0, // one MurmurHash3 call per element
+    avx2 = 1, // 8 elements per instruction for the 32-bit hash, 4 for the 64-bit one
+    avx512 = 2, // 16 elements per instruction for the 32-bit hash, 8 for the 64-bit one
+};
+
+// Method to get the fastest kernel the processor supports
+HashKernel BestHashKernel();
+
+// Method to get the name of a kernel
+const char *HashKernelName(HashKernel kernel);
+
+// Method to hash count elements with MurmurHash3_x86_128 under one seed, writes the first 64 bits of every hash to
+// out. Kernels the processor does not support fall back to the best one it does; all of them give the same output.
+void MurmurHash3_x86_128_Low64Batch(const ElementType *elements, uint64 count, uint32 seed, uint64 *out,
+                                    HashKernel kernel = BestHashKernel());
+
+// Method to hash count elements with MurmurHash3_x64_128 under one seed, writes the two halves of the hash of
+// element i to out[2 * i] and out[2 * i + 1]
+void MurmurHash3_x64_128_Batch(const ElementType *elements, uint64 count, uint32 seed, uint64 *out,
+                               HashKernel kernel = BestHashKernel());
+
+#endif // OTMPSI_UTILS_MURMURBATCH_H_
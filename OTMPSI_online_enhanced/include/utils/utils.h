@@ -1,6 +1,8 @@
 #ifndef OTMPSI_UTILS_UTILS_H_
 #define OTMPSI_UTILS_UTILS_H_
 
+#include <string_view>
+
 #include "common.h"
 
 // Function to read an experiment configuration from a JSON file
@@ -9,6 +11,15 @@ void NewConfigFromJsonFile(ExperimentConfig &config, const std::string &json_fil
 // Function to generate a set of elements
 void generate_set(std::vector<ElementType> &set, const ExperimentConfig &config);
 
+// Function to seed the random generator of NTL, which the protocol draws its randomness from, from the random device
+// of the system
+void SeedRandomGenerator();
+
+// Function to hash an identifier of any length, e.g. an email address or a UUID, to an element. The element is the
+// MurmurHash3_x64_128 digest of the identifier cut to the width of the element type, so identifiers are hashed once
+// when the set is read and 128-bit digests are not hashed again by the Bloom filter
+ElementType DigestElement(std::string_view identifier);
+
 // Helper method to format a number of bytes in a more readable form
 std::string FormatBytes(uint64 bytes);
 
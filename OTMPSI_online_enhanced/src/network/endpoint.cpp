@@ -0,0 +1,39 @@
+#include "network/endpoint.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "network/emulated_endpoint.h"
+#include "network/shm_endpoint.h"
+#include "network/tcp_endpoint.h"
+#include "network/uring_endpoint.h"
+
+// Method to block until at least num_connections remote endpoints are connected, polls by default
+void Endpoint::WaitForConnections(uint32 num_connections) {
+    while (GetRemoteNames().size() < num_connections) {
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+}
+
+// Function to create the endpoint selected by the transport option, wrapped into an emulated network if enabled
+Endpoint *NewEndpoint(const Options &options) {
+    Endpoint *endpoint;
+    if (options.transport == "tcp") {
+        endpoint = new TcpEndpoint(options.port, options.tcp);
+    } else if (options.transport == "shm") {
+        endpoint = new ShmEndpoint(options.port);
+    } else if (options.transport == "uring") {
+#ifdef OTMPSI_HAVE_IO_URING
+        endpoint = new UringEndpoint(options.port, options.uring_zero_copy_threshold);
+#else
+        throw std::invalid_argument("transport uring needs Linux with io_uring headers");
+#endif
+    } else {
+        throw std::invalid_argument("unknown transport: " + options.transport);
+    }
+    if (options.network_emulation.enabled) {
+        endpoint = new EmulatedEndpoint(endpoint, options.network_emulation, options.local_name);
+    }
+    return endpoint;
+}
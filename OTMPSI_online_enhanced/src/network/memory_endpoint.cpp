@@ -0,0 +1,244 @@
+#include "network/memory_endpoint.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+// Destructor that frees the messages never read
+MemoryLink::~MemoryLink() {
+    for (const auto &chunk: chunks) {
+        free(chunk.data);
+    }
+}
+
+// Method to register an endpoint under its listening port, returns the scheduling id of the endpoint
+uint32 MemoryNetwork::Register(uint32 port, MemoryEndpoint *endpoint) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    endpoints_[port] = endpoint;
+    blocked_.emplace_back();
+    finished_.push_back(false);
+    return blocked_.size() - 1;
+}
+
+// Method to find the endpoint listening on a port
+MemoryEndpoint *MemoryNetwork::Lookup(uint32 port) {
+    auto it = endpoints_.find(port);
+    if (it == endpoints_.end()) {
+        throw std::invalid_argument("no in-memory endpoint listening on port " + std::to_string(port));
+    }
+    return it->second;
+}
+
+// Method to wait for the turn of a participant thread before it starts running
+void MemoryNetwork::Enter(uint32 id) {
+    if (deterministic_) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [&] { return running_ == id || failure_; });
+        ThrowIfFailed();
+    }
+}
+
+// Method to hand the turn over when a participant thread has finished
+void MemoryNetwork::Leave(uint32 id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    finished_[id] = true;
+    if (deterministic_ && !failure_) {
+        PassTurn(id);
+    }
+}
+
+// Method to block the calling participant until a condition holds, the lock must be held by the caller
+void MemoryNetwork::Block(std::unique_lock<std::mutex> &lock, uint32 id, const std::function<bool()> &ready) {
+    if (!deterministic_) {
+        cv_.wait(lock, [&] { return failure_ || ready(); });
+        ThrowIfFailed();
+        return;
+    }
+    ThrowIfFailed();
+    if (ready()) {
+        return;
+    }
+    blocked_[id] = ready;
+    PassTurn(id);
+    cv_.wait(lock, [&] { return running_ == id || failure_; });
+    blocked_[id] = nullptr;
+    ThrowIfFailed();
+}
+
+// Method to record the failure of a participant thread and wake up the others, only the first one is kept
+void MemoryNetwork::Fail(std::exception_ptr failure) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!failure_) {
+        failure_ = std::move(failure);
+    }
+    cv_.notify_all();
+}
+
+// Method to get the first failure recorded, null if no participant failed
+std::exception_ptr MemoryNetwork::failure() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return failure_;
+}
+
+// Method to pass the turn to the next runnable participant after id, records a failure if there is none
+void MemoryNetwork::PassTurn(uint32 id) {
+    uint32 n = blocked_.size();
+    bool all_finished = true;
+    for (uint32 k = 1; k <= n; k++) {
+        uint32 next = (id + k) % n;
+        if (finished_[next]) {
+            continue;
+        }
+        all_finished = false;
+        if (!blocked_[next] || blocked_[next]()) {
+            running_ = next;
+            cv_.notify_all();
+            return;
+        }
+    }
+    if (!all_finished) {
+        failure_ = std::make_exception_ptr(std::runtime_error("simulation deadlocked: every participant is blocked"));
+        cv_.notify_all();
+    }
+}
+
+// Method to throw in a participant that was woken up by the failure of another, the lock must be held
+void MemoryNetwork::ThrowIfFailed() const {
+    if (failure_) {
+        throw std::runtime_error("simulation aborted after the failure of a participant");
+    }
+}
+
+// Method to stop the endpoint
+void MemoryEndpoint::Stop() {
+    std::lock_guard<std::mutex> lock(network_.mtx_);
+    channels_.clear();
+}
+
+// Method to connect to a remote endpoint. Both directions are created at once and registered on both sides.
+void
+MemoryEndpoint::Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) {
+    uint32 port = std::stoul(remote_address.substr(remote_address.find(':') + 1));
+
+    std::lock_guard<std::mutex> lock(network_.mtx_);
+    MemoryEndpoint *remote = network_.Lookup(port);
+    auto to_remote = std::make_shared<MemoryLink>();
+    auto from_remote = std::make_shared<MemoryLink>();
+    channels_[remote_name] = Channel{to_remote, from_remote};
+    remote->channels_[local_name] = Channel{from_remote, to_remote};
+    network_.Notify();
+}
+
+// Method to block until at least num_connections remote endpoints are connected
+void MemoryEndpoint::WaitForConnections(uint32 num_connections) {
+    std::unique_lock<std::mutex> lock(network_.mtx_);
+    network_.Block(lock, id_, [&] { return channels_.size() >= num_connections; });
+}
+
+// Method to close a connection with a remote endpoint
+void MemoryEndpoint::CloseChannel(const std::string &remote_name) {
+    std::lock_guard<std::mutex> lock(network_.mtx_);
+    channels_.erase(remote_name);
+}
+
+// Method to deliver a message on a link, taking ownership of data if owned is set, the lock must be held
+void MemoryEndpoint::Deliver(MemoryLink &link, const uint8 *data, uint32 len, bool owned) {
+    uint32 offset = 0;
+
+    // Fill the buffer of a blocked reader directly if nothing is queued before this message
+    if (link.pending_read != nullptr && link.chunks.empty()) {
+        offset = std::min(len, link.pending_len);
+        std::memcpy(link.pending_read, data, offset);
+        link.pending_read += offset;
+        link.pending_len -= offset;
+        if (link.pending_len == 0) {
+            link.pending_read = nullptr;
+        }
+    }
+
+    // Queue whatever the reader has not taken yet
+    if (offset < len) {
+        if (owned) {
+            link.chunks.push_back({const_cast<uint8 *>(data), len, offset});
+        } else {
+            auto copy = static_cast<uint8 *>(malloc(len - offset));
+            std::memcpy(copy, data + offset, len - offset);
+            link.chunks.push_back({copy, len - offset, 0});
+        }
+    } else if (owned) {
+        free(const_cast<uint8 *>(data));
+    }
+
+    network_.Notify();
+}
+
+// Method to write data to a remote endpoint
+void MemoryEndpoint::Write(const std::string &remote_name, const void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(network_.mtx_);
+        Deliver(*channels_.at(remote_name).out, static_cast<const uint8 *>(buf), len, false);
+    }
+    stats_.RecordWrite(remote_name, len, 0, start);
+}
+
+// Method to asynchronously write data to a remote endpoint, the buffer is handed over and freed once read
+void MemoryEndpoint::AsyncWrite(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(network_.mtx_);
+        Deliver(*channels_.at(remote_name).out, static_cast<const uint8 *>(buf), len, true);
+    }
+    stats_.RecordWrite(remote_name, len, 0, start);
+}
+
+// Method to read data from a remote endpoint
+void MemoryEndpoint::Read(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    uint32 total = len;
+    std::unique_lock<std::mutex> lock(network_.mtx_);
+    auto link = channels_.at(remote_name).in;
+    auto dst = static_cast<uint8 *>(buf);
+
+    // Take queued messages first
+    while (len > 0 && !link->chunks.empty()) {
+        auto &chunk = link->chunks.front();
+        uint32 n = std::min(len, chunk.len - chunk.offset);
+        std::memcpy(dst, chunk.data + chunk.offset, n);
+        chunk.offset += n;
+        dst += n;
+        len -= n;
+        if (chunk.offset == chunk.len) {
+            free(chunk.data);
+            link->chunks.pop_front();
+        }
+    }
+
+    // Let the writer fill the rest in place, and withdraw the buffer if the simulation is aborted while waiting, as
+    // the peers that are still running must not write into it once the stack has unwound
+    if (len > 0) {
+        link->pending_read = dst;
+        link->pending_len = len;
+        try {
+            network_.Block(lock, id_, [&] { return link->pending_len == 0; });
+        } catch (...) {
+            link->pending_read = nullptr;
+            link->pending_len = 0;
+            throw;
+        }
+    }
+    lock.unlock();
+    stats_.RecordRead(remote_name, total, 0, start);
+}
+
+// Method to get the names of all connected remote endpoints
+std::vector<std::string> MemoryEndpoint::GetRemoteNames() {
+    std::lock_guard<std::mutex> lock(network_.mtx_);
+    std::vector<std::string> remotes;
+    remotes.reserve(channels_.size());
+    for (const auto &channel: channels_) {
+        remotes.push_back(channel.first);
+    }
+    return remotes;
+}
\ No newline at end of file
@@ -2,6 +2,22 @@
 
 #include <boost/bind/bind.hpp>
 
+// Constructor that takes a port number and the options of the channels
+TcpEndpoint::TcpEndpoint(int port, const TcpOptions &options)
+        : options_(options), acceptor_(io_service_), resolver_(io_service_) {
+    // Accepted connections inherit the buffer sizes of the acceptor, which have to be set before listening so that
+    // the window scale offered in the handshake can make use of them
+    acceptor_.open(tcp::v4());
+    acceptor_.set_option(tcp::acceptor::reuse_address(true));
+    if (options_.receive_buffer_bytes > 0) {
+        acceptor_.set_option(boost::asio::socket_base::receive_buffer_size(options_.receive_buffer_bytes));
+    }
+    if (options_.send_buffer_bytes > 0) {
+        acceptor_.set_option(boost::asio::socket_base::send_buffer_size(options_.send_buffer_bytes));
+    }
+    acceptor_.bind(tcp::endpoint(tcp::v4(), port));
+    acceptor_.listen();
+}
 
 // Method to stop the endpoint
 void TcpEndpoint::Stop() {
@@ -14,8 +30,9 @@ void TcpEndpoint::Stop() {
 };
 
 
-// Method to get the names of all connected remote endpoints
+// Method to get the names of all connected remote endpoints, channels count once all their streams are connected
 std::vector<std::string> TcpEndpoint::GetRemoteNames() {
+    std::lock_guard<std::mutex> lock(channels_mtx_);
     std::vector<std::string> remotes;
     remotes.reserve(channels_.size());
 
@@ -39,7 +56,7 @@ void TcpChannel::DoWrite() {
         }
         // Start an asynchronous write operation
         boost::asio::async_write(
-                socket_, buffer_seq_,
+                sockets_[0], buffer_seq_,
                 boost::bind(&TcpChannel::WriteHandler, shared_from_this(), boost::asio::placeholders::error,
                             boost::asio::placeholders::bytes_transferred));
     }
@@ -65,30 +82,55 @@ void TcpChannel::WriteHandler(const boost::system::error_code &error, size_t siz
     }
 }
 
-// Method to connect to a remote endpoint
-void
-TcpEndpoint::Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) {
+// Function to set the socket options of a TCP connection
+void ApplyTcpOptions(tcp::socket &socket, const TcpOptions &options) {
+    if (options.send_buffer_bytes > 0) {
+        socket.set_option(boost::asio::socket_base::send_buffer_size(options.send_buffer_bytes));
+    }
+    if (options.receive_buffer_bytes > 0) {
+        socket.set_option(boost::asio::socket_base::receive_buffer_size(options.receive_buffer_bytes));
+    }
+    if (options.no_delay) {
+        socket.set_option(tcp::no_delay(true));
+    }
+#ifdef TCP_QUICKACK
+    if (options.quick_ack) {
+        socket.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_QUICKACK>(true));
+    }
+#endif
+}
+
+// Function to connect a socket to a remote address of the form "host:port", retrying while the remote is not up yet.
+// The options, if given, are applied before connecting so that the buffer sizes count for the window negotiation.
+void ConnectSocket(tcp::socket &socket, tcp::resolver &resolver, const std::string &remote_address,
+                   const TcpOptions *options) {
     // Parse the remote address and port from the input string
     std::string addr = remote_address.substr(0, remote_address.find(':'));
     std::string port =
             remote_address.substr(remote_address.find(':') + 1, remote_address.length() - remote_address.find(':') - 1);
     // Resolve the remote address
     tcp::resolver::query query(addr, port, tcp::resolver::query::canonical_name);
-    tcp::resolver::iterator endpoint_iterator = resolver_.resolve(query);
+    tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
     tcp::resolver::iterator end;
 
-    // Create a new TcpChannel object
-    TcpChannel::TcpChannelPointer new_connection = TcpChannel::Create(this->io_service_);
+    // Open a fresh socket with the options set and connect it
+    auto try_connect = [&](const tcp::endpoint &endpoint, boost::system::error_code &error) {
+        socket.close();
+        if (options != nullptr) {
+            socket.open(endpoint.protocol());
+            ApplyTcpOptions(socket, *options);
+        }
+        socket.connect(endpoint, error);
+    };
+
     // Try to connect to the remote endpoint
     boost::system::error_code error = boost::asio::error::host_not_found;
     while (error && endpoint_iterator != end) {
         int cnt = 0;
-        new_connection->socket().close();
-        new_connection->socket().connect(*endpoint_iterator, error);
+        try_connect(*endpoint_iterator, error);
         // Retry connecting if the connection was refused
         while (error == boost::asio::error::connection_refused && cnt < retryLimit) {
-            new_connection->socket().close();
-            new_connection->socket().connect(*endpoint_iterator, error);
+            try_connect(*endpoint_iterator, error);
             cnt++;
 // std::cout << "retry connecting to " << remote_name << " in 3 seconds" << std::endl;
             std::this_thread::sleep_for(std::chrono::seconds(3));
@@ -97,28 +139,26 @@ TcpEndpoint::Connect(const std::string &remote_name, const std::string &remote_a
     }
     // Check if there was an error
     if (error) throw boost::system::system_error(error);
+}
 
-    const char *cstr = local_name.c_str();
-    new_connection->Write(cstr, nameSizeLimit);
+// Method to connect to a remote endpoint
+void
+TcpEndpoint::Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) {
+    // Create a new TcpChannel object and connect each of its streams to the remote endpoint
+    TcpChannel::TcpChannelPointer new_connection = TcpChannel::Create(this->io_service_, options_.streams,
+                                                                      options_.stripe_bytes, options_.quick_ack);
+    char buffer[nameSizeLimit] = {0};
+    local_name.copy(buffer, nameSizeLimit - 1);
+    for (uint32 i = 0; i < options_.streams; i++) {
+        ConnectSocket(new_connection->socket(i), resolver_, remote_address, &options_);
+
+        // The handshake goes straight to the socket, so that it does not shift the stripes of the channel
+        TcpStreamHeader header{i, options_.streams, options_.stripe_bytes};
+        boost::asio::write(new_connection->socket(i), boost::asio::buffer(buffer, nameSizeLimit));
+        boost::asio::write(new_connection->socket(i), boost::asio::buffer(&header, sizeof(header)));
+    }
 
     // Add the new channel to the map of channels
+    std::lock_guard<std::mutex> lock(channels_mtx_);
     channels_.insert(std::make_pair(remote_name, new_connection));
 }
-
-
-// Method to get the total amount of data sent in a more readable form
-uint64 TcpEndpoint::GetTotalBytesSent() const {
-    return total_bytes_sent_;
-}
-
-// Method to get the total amount of data received in a more readable form
-uint64 TcpEndpoint::GetTotalBytesReceived() const {
-    return total_bytes_received_;
-}
-
-
-// Method to reset the counters
-void TcpEndpoint::ResetCounters() {
-    total_bytes_sent_ = 0;
-    total_bytes_received_ = 0;
-}
@@ -0,0 +1,88 @@
+#include "network/traffic_stats.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+// Method to attribute subsequent traffic to a phase, registering the phase on first use
+void TrafficStats::SetPhase(const std::string &phase) {
+    std::lock_guard<std::shared_mutex> lock(mtx_);
+    auto it = std::find(phases_.begin(), phases_.end(), phase);
+    if (it == phases_.end()) {
+        if (phases_.size() == maxTrafficPhases) {
+            throw std::length_error("too many traffic phases, cannot add " + phase);
+        }
+        it = phases_.insert(phases_.end(), phase);
+    }
+    phase_ = static_cast<int>(it - phases_.begin());
+}
+
+// Method to get the counters of a remote endpoint in the current phase
+TrafficCounters &TrafficStats::counters(const std::string &remote_name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        auto it = remotes_.find(remote_name);
+        if (it != remotes_.end()) {
+            return (*it->second)[phase_];
+        }
+    }
+    std::lock_guard<std::shared_mutex> lock(mtx_);
+    auto &slot = remotes_[remote_name];
+    if (!slot) {
+        slot = std::make_unique<PhaseCounters>();
+    }
+    return (*slot)[phase_];
+}
+
+// Nanoseconds elapsed since start
+static uint64 ElapsedNs(TrafficStats::Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(TrafficStats::Clock::now() - start).count();
+}
+
+// Method to record a message written to a remote endpoint
+void TrafficStats::RecordWrite(const std::string &remote_name, uint64 bytes, uint64 syscalls,
+                               Clock::time_point start) {
+    auto &c = counters(remote_name);
+    c.bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+    c.messages_sent.fetch_add(1, std::memory_order_relaxed);
+    c.syscalls.fetch_add(syscalls, std::memory_order_relaxed);
+    c.write_blocked_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+    total_bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// Method to record a message read from a remote endpoint
+void TrafficStats::RecordRead(const std::string &remote_name, uint64 bytes, uint64 syscalls,
+                              Clock::time_point start) {
+    auto &c = counters(remote_name);
+    c.bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+    c.messages_received.fetch_add(1, std::memory_order_relaxed);
+    c.syscalls.fetch_add(syscalls, std::memory_order_relaxed);
+    c.read_blocked_ns.fetch_add(ElapsedNs(start), std::memory_order_relaxed);
+    total_bytes_received_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// Method to get the counters per phase and remote endpoint as JSON
+nlohmann::json TrafficStats::ToJson() const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    nlohmann::json phases = nlohmann::json::array();
+    for (size_t i = 0; i < phases_.size(); i++) {
+        nlohmann::json remotes = nlohmann::json::object();
+        for (const auto &[remote_name, counters]: remotes_) {
+            const auto &c = (*counters)[i];
+            if (c.messages_sent == 0 && c.messages_received == 0) {
+                continue;
+            }
+            remotes[remote_name] = {
+                    {"bytesSent",        c.bytes_sent.load()},
+                    {"bytesReceived",    c.bytes_received.load()},
+                    {"messagesSent",     c.messages_sent.load()},
+                    {"messagesReceived", c.messages_received.load()},
+                    {"syscalls",         c.syscalls.load()},
+                    {"writeBlockedMs",   c.write_blocked_ns.load() / 1e6},
+                    {"readBlockedMs",    c.read_blocked_ns.load() / 1e6},
+            };
+        }
+        phases.push_back({{"phase", phases_[i]}, {"remotes", remotes}});
+    }
+    return phases;
+}
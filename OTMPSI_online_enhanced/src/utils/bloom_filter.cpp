@@ -1,42 +1,175 @@
 #include "utils/bloom_filter.h"
 
-#include "third_party/smhasher/MurmurHash3.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
 
+#include "utils/murmur_batch.h"
+#include "utils/parallel.h"
 
-std::vector<ContainerSizeType>
-GetHashPositions(const ElementType &e, ContainerSizeType size, const std::vector<uint> &murmurhash_seeds) {
-    std::vector<ContainerSizeType> positions;
-    positions.reserve(murmurhash_seeds.size());
+// Number of elements hashed per batch, the hashes of a batch stay in the first level cache
+const uint64 hashBatchSize = 512;
 
-    uint64 hash[2];
-    // Compute multiple hash values for the element using different seeds
-    for (auto &seed: murmurhash_seeds) {
-        MurmurHash3_x86_128(&e, elementTypeWords, seed, hash);
-        ContainerSizeType pos = hash[0] % size;
-        positions.emplace_back(pos);
+// Constructor that takes the size of the filter, the MurmurHash seeds, the layout and the size of a block
+BloomFilterHasher::BloomFilterHasher(ContainerSizeType size, const std::vector<uint32> &murmurhash_seeds,
+                                     BloomFilterLayout layout, uint32 block_bits)
+        : size_(size), size_modulo_(std::max<ContainerSizeType>(size, 1)), murmurhash_seeds_(murmurhash_seeds),
+          layout_(layout), block_bits_(block_bits),
+          num_blocks_(std::max<ContainerSizeType>(size / std::max<uint32>(block_bits, 1), 1)) {
+    if (layout_ != BloomFilterLayout::seeded && murmurhash_seeds_.empty()) {
+        throw std::invalid_argument("the hashed Bloom filter layouts need at least one seed");
     }
+    if (layout_ == BloomFilterLayout::blocked && block_bits_ == 0) {
+        throw std::invalid_argument("the blocks of a Bloom filter must not be empty");
+    }
+}
 
+// Method to get all the positions of an element
+std::vector<ContainerSizeType> GetHashPositions(const ElementType &e, const BloomFilterHasher &hasher) {
+    std::vector<ContainerSizeType> positions;
+    positions.reserve(hasher.num_hashes());
+    hasher.ForEachPosition(e, [&positions](ContainerSizeType pos) {
+        positions.emplace_back(pos);
+        return true;
+    });
     return positions;
 }
 
+// Method to write the positions of count elements to positions, element after element
+void BloomFilterHasher::Positions(const ElementType *elements, uint64 count, ContainerSizeType *positions) const {
+    uint32 k = num_hashes();
+    uint64 hashes[2 * hashBatchSize];
+    for (uint64 begin = 0; begin < count; begin += hashBatchSize) {
+        uint64 n = std::min(hashBatchSize, count - begin);
+        ContainerSizeType *batch_positions = positions + begin * k;
+        if (layout_ == BloomFilterLayout::seeded) {
+            // One pass over the batch per seed, the positions of a seed are a column of the batch
+            for (uint32 j = 0; j < k; j++) {
+                MurmurHash3_x86_128_Low64Batch(elements + begin, n, murmurhash_seeds_[j], hashes);
+                for (uint64 i = 0; i < n; i++) {
+                    batch_positions[i * k + j] = size_modulo_(hashes[i]);
+                }
+            }
+            continue;
+        }
+
+        if constexpr (elementsAreDigests) {
+            std::memcpy(hashes, elements + begin, n * sizeof(ElementType));
+        } else {
+            MurmurHash3_x64_128_Batch(elements + begin, n, murmurhash_seeds_[0], hashes);
+        }
+        for (uint64 i = 0; i < n; i++) {
+            ContainerSizeType *out = batch_positions + i * k;
+            DerivePositions(hashes + 2 * i, [&out](ContainerSizeType pos) {
+                *out++ = pos;
+                return true;
+            });
+        }
+    }
+}
+
+// Method to compute the positions of all elements, in parallel
+void HashPositionMatrix::Compute(const BloomFilterHasher &hasher, const std::vector<ElementType> &elements,
+                                 uint32 num_threads) {
+    rows_ = elements.size();
+    num_hashes_ = hasher.num_hashes();
+    uint64 needed = rows_ * num_hashes_;
+    if (needed > capacity_) {
+        // aligned_alloc takes whole cache lines only
+        const uint64 line = 64;
+        uint64 bytes = (needed * sizeof(ContainerSizeType) + line - 1) / line * line;
+        data_.reset(static_cast<ContainerSizeType *>(std::aligned_alloc(line, bytes)));
+        if (!data_) {
+            throw std::bad_alloc();
+        }
+        capacity_ = needed;
+    }
+
+    ContainerSizeType *data = data_.get();
+    ParallelFor(rows_, num_threads, [&](uint64 begin, uint64 end) {
+        hasher.Positions(elements.data() + begin, end - begin, data + begin * num_hashes_);
+    });
+    computed_ = true;
+}
 
 // Method to insert an element into the Bloom filter
 void BloomFilter::Insert(const ElementType &e) {
-    // Set all positions to 1
-    for (auto pos: GetHashPositions(e, size_, murmurhash_seeds_)) {
-        bit_array_[pos] = 1;
-    }
+    // Set the bit at every position of the element
+    hasher_.ForEachPosition(e, [this](ContainerSizeType pos) {
+        words_[pos / 64] |= uint64(1) << (pos % 64);
+        return true;
+    });
 }
 
-// Method to check if an element is in the Bloom filter
-bool BloomFilter::CheckElement(const ElementType &e) {
-    // Check whether all the positions are 1
-    for (auto pos: GetHashPositions(e, size_, murmurhash_seeds_)) {
-        if (bit_array_[pos] == 0) {
-            return false;
+// Method to set the bits at count positions, with atomic ORs if other threads set bits of the filter at the same time
+void BloomFilter::SetPositions(const ContainerSizeType *positions, uint64 count, bool concurrent) {
+    if (concurrent) {
+        for (uint64 i = 0; i < count; i++) {
+            std::atomic_ref<uint64>(words_[positions[i] / 64])
+                    .fetch_or(uint64(1) << (positions[i] % 64), std::memory_order_relaxed);
+        }
+    } else {
+        for (uint64 i = 0; i < count; i++) {
+            words_[positions[i] / 64] |= uint64(1) << (positions[i] % 64);
         }
     }
-    return true;
 }
 
+// Method to insert all elements of a set into the Bloom filter, hashing them in batches on num_threads threads
+void BloomFilter::InsertAll(std::span<const ElementType> elements, uint32 num_threads) {
+    ParallelFor(elements.size(), num_threads, [&](uint64 begin, uint64 end) {
+        // Only a range that is not the whole set shares the filter with other threads
+        bool concurrent = end - begin < elements.size();
+        std::vector<ContainerSizeType> positions(hashBatchSize * hasher_.num_hashes());
+        for (uint64 i = begin; i < end; i += hashBatchSize) {
+            uint64 n = std::min<uint64>(hashBatchSize, end - i);
+            hasher_.Positions(elements.data() + i, n, positions.data());
+            SetPositions(positions.data(), n * hasher_.num_hashes(), concurrent);
+        }
+    });
+}
+
+// Method to insert all elements of a set into the Bloom filter, from their precomputed positions, on num_threads
+// threads
+void BloomFilter::InsertAll(const HashPositionMatrix &positions, uint32 num_threads) {
+    ParallelFor(positions.rows(), num_threads, [&](uint64 begin, uint64 end) {
+        SetPositions(positions.row(begin), (end - begin) * positions.num_hashes(), end - begin < positions.rows());
+    });
+}
+
+// Method to check which elements of a set are in the Bloom filter on num_threads threads, found[i] is set to 1 if
+// element i is and to 0 otherwise
+void BloomFilter::CheckAll(std::span<const ElementType> elements, std::span<uint8> found, uint32 num_threads) const {
+    if (found.size() < elements.size()) {
+        throw std::invalid_argument("CheckAll needs a result for every element");
+    }
+    const uint32 k = hasher_.num_hashes();
+    ParallelFor(elements.size(), num_threads, [&](uint64 begin, uint64 end) {
+        std::vector<ContainerSizeType> positions(hashBatchSize * k);
+        for (uint64 i = begin; i < end; i += hashBatchSize) {
+            uint64 n = std::min<uint64>(hashBatchSize, end - i);
+            hasher_.Positions(elements.data() + i, n, positions.data());
+            // AND the bits of all positions of an element, without branching on them
+            for (uint64 j = 0; j < n; j++) {
+                const ContainerSizeType *row = positions.data() + j * k;
+                uint64 bit = 1;
+                for (uint32 h = 0; h < k; h++) {
+                    bit &= words_[row[h] / 64] >> (row[h] % 64);
+                }
+                found[i + j] = bit;
+            }
+        }
+    });
+}
 
+// Method to check if an element is in the Bloom filter
+bool BloomFilter::CheckElement(const ElementType &e) {
+    // Check if the bits at all positions of the element are set, stopping at the first one that is not
+    bool found = true;
+    hasher_.ForEachPosition(e, [this, &found](ContainerSizeType pos) {
+        found = CheckPosition(pos);
+        return found;
+    });
+    return found;
+}
@@ -0,0 +1,293 @@
+#include "utils/murmur_batch.h"
+
+#include "third_party/smhasher/MurmurHash3.h"
+
+// The vector kernels are compiled for their instruction sets through target attributes and picked at run time, so
+// the rest of the build does not depend on the processor it runs on
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OTMPSI_HASH_KERNELS_X86 1
+#include <immintrin.h>
+// GCC 12 reports the deliberately undefined inputs of the AVX-512 intrinsics as maybe uninitialized
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// The kernels below unroll MurmurHash3 for keys of exactly one 4-byte block. For such a key only the first of the
+// four (x86) or two (x64) lanes of the state absorbs the key, so the other lanes are constants of the seed.
+
+namespace {
+
+// Key length the kernels are unrolled for
+const uint32 keyBytes = 4;
+
+// Whether the vector kernels apply to the element type
+constexpr bool vectorizable = sizeof(ElementType) == keyBytes;
+
+// Hash count elements one by one with MurmurHash3_x86_128, keeping the first 64 bits
+void X86Low64Scalar(const ElementType *elements, uint64 count, uint32 seed, uint64 *out) {
+    uint64 hash[2];
+    for (uint64 i = 0; i < count; i++) {
+        MurmurHash3_x86_128(&elements[i], elementTypeWords, seed, hash);
+        out[i] = hash[0];
+    }
+}
+
+// Hash count elements one by one with MurmurHash3_x64_128
+void X64Scalar(const ElementType *elements, uint64 count, uint32 seed, uint64 *out) {
+    for (uint64 i = 0; i < count; i++) {
+        MurmurHash3_x64_128(&elements[i], elementTypeWords, seed, out + 2 * i);
+    }
+}
+
+#ifdef OTMPSI_HASH_KERNELS_X86
+
+// Constants of MurmurHash3_x86_128 and fmix32
+const uint32 x86C1 = 0x239b961b;
+const uint32 x86C2 = 0xab0e9789;
+const uint32 fmix32C1 = 0x85ebca6b;
+const uint32 fmix32C2 = 0xc2b2ae35;
+
+// Constants of MurmurHash3_x64_128 and fmix64
+const uint64 x64C1 = 0x87c37b91114253d5ULL;
+const uint64 x64C2 = 0x4cf5ad432745937fULL;
+const uint64 fmix64C1 = 0xff51afd7ed558ccdULL;
+const uint64 fmix64C2 = 0xc4ceb9fe1a85ec53ULL;
+
+// Rotate the 32-bit lanes of a left by r bits
+__attribute__((target("avx2"))) inline __m256i Rotl32Avx2(__m256i a, int r) {
+    return _mm256_or_si256(_mm256_slli_epi32(a, r), _mm256_srli_epi32(a, 32 - r));
+}
+
+// Rotate the 64-bit lanes of a left by r bits
+__attribute__((target("avx2"))) inline __m256i Rotl64Avx2(__m256i a, int r) {
+    return _mm256_or_si256(_mm256_slli_epi64(a, r), _mm256_srli_epi64(a, 64 - r));
+}
+
+// Multiply the 64-bit lanes of a by c, AVX2 only multiplies 32-bit halves
+__attribute__((target("avx2"))) inline __m256i Mul64Avx2(__m256i a, uint64 c) {
+    __m256i b = _mm256_set1_epi64x(static_cast<long long>(c));
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+// fmix32 on 32-bit lanes
+__attribute__((target("avx2"))) inline __m256i Fmix32Avx2(__m256i h) {
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(fmix32C1)));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int>(fmix32C2)));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+// fmix64 on 64-bit lanes
+__attribute__((target("avx2"))) inline __m256i Fmix64Avx2(__m256i k) {
+    k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+    k = Mul64Avx2(k, fmix64C1);
+    k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+    k = Mul64Avx2(k, fmix64C2);
+    return _mm256_xor_si256(k, _mm256_srli_epi64(k, 33));
+}
+
+// MurmurHash3_x86_128 of 8 elements per iteration, keeping the first 64 bits
+__attribute__((target("avx2"))) void X86Low64Avx2(const uint32 *elements, uint64 count, uint32 seed, uint64 *out) {
+    // h2, h3 and h4 hold the seed xor the length until they are mixed with h1
+    const __m256i s = _mm256_set1_epi32(static_cast<int>(seed ^ keyBytes));
+    const __m256i s3 = _mm256_set1_epi32(static_cast<int>(3 * (seed ^ keyBytes)));
+    uint64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i k1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(elements + i));
+        k1 = _mm256_mullo_epi32(k1, _mm256_set1_epi32(static_cast<int>(x86C1)));
+        k1 = Rotl32Avx2(k1, 15);
+        k1 = _mm256_mullo_epi32(k1, _mm256_set1_epi32(static_cast<int>(x86C2)));
+
+        __m256i h1 = _mm256_add_epi32(_mm256_xor_si256(s, k1), s3);
+        __m256i h2 = _mm256_add_epi32(s, h1);
+        h1 = Fmix32Avx2(h1);
+        h2 = Fmix32Avx2(h2);
+        h1 = _mm256_add_epi32(h1, _mm256_add_epi32(h2, _mm256_add_epi32(h2, h2)));
+        h2 = _mm256_add_epi32(h2, h1);
+
+        // The first 64 bits of the hash are h1 followed by h2
+        __m256i lo = _mm256_or_si256(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(h1)),
+                                     _mm256_slli_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(h2)), 32));
+        __m256i hi = _mm256_or_si256(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(h1, 1)),
+                                     _mm256_slli_epi64(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(h2, 1)), 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 4), hi);
+    }
+    X86Low64Scalar(reinterpret_cast<const ElementType *>(elements) + i, count - i, seed, out + i);
+}
+
+// MurmurHash3_x64_128 of 4 elements per iteration
+__attribute__((target("avx2"))) void X64Avx2(const uint32 *elements, uint64 count, uint32 seed, uint64 *out) {
+    // h2 holds the seed xor the length until it is mixed with h1
+    const __m256i s = _mm256_set1_epi64x(static_cast<long long>(seed ^ keyBytes));
+    uint64 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i k1 = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(elements + i)));
+        k1 = Mul64Avx2(k1, x64C1);
+        k1 = Rotl64Avx2(k1, 31);
+        k1 = Mul64Avx2(k1, x64C2);
+
+        __m256i h1 = _mm256_add_epi64(_mm256_xor_si256(s, k1), s);
+        __m256i h2 = _mm256_add_epi64(s, h1);
+        h1 = Fmix64Avx2(h1);
+        h2 = Fmix64Avx2(h2);
+        h1 = _mm256_add_epi64(h1, h2);
+        h2 = _mm256_add_epi64(h2, h1);
+
+        // Interleave the halves, unpack works within 128-bit lanes
+        __m256i even = _mm256_unpacklo_epi64(h1, h2);
+        __m256i odd = _mm256_unpackhi_epi64(h1, h2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i), _mm256_permute2x128_si256(even, odd, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i + 4), _mm256_permute2x128_si256(even, odd, 0x31));
+    }
+    X64Scalar(reinterpret_cast<const ElementType *>(elements) + i, count - i, seed, out + 2 * i);
+}
+
+// fmix32 on 32-bit lanes
+__attribute__((target("avx512f"))) inline __m512i Fmix32Avx512(__m512i h) {
+    h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(static_cast<int>(fmix32C1)));
+    h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 13));
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(static_cast<int>(fmix32C2)));
+    return _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+}
+
+// fmix64 on 64-bit lanes
+__attribute__((target("avx512f,avx512dq"))) inline __m512i Fmix64Avx512(__m512i k) {
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(static_cast<long long>(fmix64C1)));
+    k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(static_cast<long long>(fmix64C2)));
+    return _mm512_xor_si512(k, _mm512_srli_epi64(k, 33));
+}
+
+// MurmurHash3_x86_128 of 16 elements per iteration, keeping the first 64 bits
+__attribute__((target("avx512f"))) void X86Low64Avx512(const uint32 *elements, uint64 count, uint32 seed,
+                                                      uint64 *out) {
+    const __m512i s = _mm512_set1_epi32(static_cast<int>(seed ^ keyBytes));
+    const __m512i s3 = _mm512_set1_epi32(static_cast<int>(3 * (seed ^ keyBytes)));
+    uint64 i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i k1 = _mm512_loadu_si512(elements + i);
+        k1 = _mm512_mullo_epi32(k1, _mm512_set1_epi32(static_cast<int>(x86C1)));
+        k1 = _mm512_rol_epi32(k1, 15);
+        k1 = _mm512_mullo_epi32(k1, _mm512_set1_epi32(static_cast<int>(x86C2)));
+
+        __m512i h1 = _mm512_add_epi32(_mm512_xor_si512(s, k1), s3);
+        __m512i h2 = _mm512_add_epi32(s, h1);
+        h1 = Fmix32Avx512(h1);
+        h2 = Fmix32Avx512(h2);
+        h1 = _mm512_add_epi32(h1, _mm512_add_epi32(h2, _mm512_add_epi32(h2, h2)));
+        h2 = _mm512_add_epi32(h2, h1);
+
+        __m512i lo = _mm512_or_si512(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(h1)),
+                                     _mm512_slli_epi64(_mm512_cvtepu32_epi64(_mm512_castsi512_si256(h2)), 32));
+        __m512i hi = _mm512_or_si512(_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(h1, 1)),
+                                     _mm512_slli_epi64(_mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(h2, 1)), 32));
+        _mm512_storeu_si512(out + i, lo);
+        _mm512_storeu_si512(out + i + 8, hi);
+    }
+    X86Low64Scalar(reinterpret_cast<const ElementType *>(elements) + i, count - i, seed, out + i);
+}
+
+// MurmurHash3_x64_128 of 8 elements per iteration
+__attribute__((target("avx512f,avx512dq"))) void X64Avx512(const uint32 *elements, uint64 count, uint32 seed,
+                                                          uint64 *out) {
+    const __m512i s = _mm512_set1_epi64(static_cast<long long>(seed ^ keyBytes));
+    // Quadwords of the 128-bit lanes of the unpacked halves, in element order
+    const __m512i first = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+    const __m512i second = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+    uint64 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512i k1 = _mm512_cvtepu32_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(elements + i)));
+        k1 = _mm512_mullo_epi64(k1, _mm512_set1_epi64(static_cast<long long>(x64C1)));
+        k1 = _mm512_rol_epi64(k1, 31);
+        k1 = _mm512_mullo_epi64(k1, _mm512_set1_epi64(static_cast<long long>(x64C2)));
+
+        __m512i h1 = _mm512_add_epi64(_mm512_xor_si512(s, k1), s);
+        __m512i h2 = _mm512_add_epi64(s, h1);
+        h1 = Fmix64Avx512(h1);
+        h2 = Fmix64Avx512(h2);
+        h1 = _mm512_add_epi64(h1, h2);
+        h2 = _mm512_add_epi64(h2, h1);
+
+        __m512i even = _mm512_unpacklo_epi64(h1, h2);
+        __m512i odd = _mm512_unpackhi_epi64(h1, h2);
+        _mm512_storeu_si512(out + 2 * i, _mm512_permutex2var_epi64(even, first, odd));
+        _mm512_storeu_si512(out + 2 * i + 8, _mm512_permutex2var_epi64(even, second, odd));
+    }
+    X64Scalar(reinterpret_cast<const ElementType *>(elements) + i, count - i, seed, out + 2 * i);
+}
+
+#endif // OTMPSI_HASH_KERNELS_X86
+
+// Lower a kernel to the best one the processor and the element type support
+HashKernel Supported(HashKernel kernel) {
+    if (!vectorizable) {
+        return HashKernel::scalar;
+    }
+    auto best = BestHashKernel();
+    return static_cast<int>(kernel) < static_cast<int>(best) ? kernel : best;
+}
+
+} // namespace
+
+// Method to get the fastest kernel the processor supports
+HashKernel BestHashKernel() {
+#ifdef OTMPSI_HASH_KERNELS_X86
+    static const HashKernel best = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+                                   ? HashKernel::avx512
+                                   : __builtin_cpu_supports("avx2") ? HashKernel::avx2 : HashKernel::scalar;
+    return best;
+#else
+    return HashKernel::scalar;
+#endif
+}
+
+// Method to get the name of a kernel
+const char *HashKernelName(HashKernel kernel) {
+    switch (kernel) {
+        case HashKernel::avx2:
+            return "avx2";
+        case HashKernel::avx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+// Method to hash count elements with MurmurHash3_x86_128 under one seed, writes the first 64 bits of every hash
+void MurmurHash3_x86_128_Low64Batch(const ElementType *elements, uint64 count, uint32 seed, uint64 *out,
+                                    HashKernel kernel) {
+    switch (Supported(kernel)) {
+#ifdef OTMPSI_HASH_KERNELS_X86
+        case HashKernel::avx512:
+            X86Low64Avx512(reinterpret_cast<const uint32 *>(elements), count, seed, out);
+            return;
+        case HashKernel::avx2:
+            X86Low64Avx2(reinterpret_cast<const uint32 *>(elements), count, seed, out);
+            return;
+#endif
+        default:
+            X86Low64Scalar(elements, count, seed, out);
+    }
+}
+
+// Method to hash count elements with MurmurHash3_x64_128 under one seed, writes both halves of every hash
+void MurmurHash3_x64_128_Batch(const ElementType *elements, uint64 count, uint32 seed, uint64 *out,
+                               HashKernel kernel) {
+    switch (Supported(kernel)) {
+#ifdef OTMPSI_HASH_KERNELS_X86
+        case HashKernel::avx512:
+            X64Avx512(reinterpret_cast<const uint32 *>(elements), count, seed, out);
+            return;
+        case HashKernel::avx2:
+            X64Avx2(reinterpret_cast<const uint32 *>(elements), count, seed, out);
+            return;
+#endif
+        default:
+            X64Scalar(elements, count, seed, out);
+    }
+}
@@ -0,0 +1,218 @@
+#include "utils/set_loader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "utils/parallel.h"
+#include "utils/utils.h"
+
+// Constructor that maps the file at path, throws if it cannot be opened
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("open " + path + ": " + std::strerror(errno));
+    }
+    struct stat st{};
+    if (fstat(fd, &st) < 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("fstat " + path + ": " + std::strerror(error));
+    }
+    size_ = st.st_size;
+    // An empty file cannot be mapped, it is left as an empty range
+    if (size_ > 0) {
+        void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error("mmap " + path + ": " + std::strerror(error));
+        }
+        // The file is read front to back, let the kernel read ahead
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(p);
+    }
+    close(fd);
+}
+
+// Destructor that unmaps the file
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+}
+
+namespace {
+
+// Function to parse a decimal number into an element, throws if the line is not one or does not fit
+ElementType ParseNumber(const char *begin, const char *end) {
+#if OTMPSI_ELEMENT_BITS <= 64
+    ElementType e = 0;
+    auto result = std::from_chars(begin, end, e);
+    if (result.ec != std::errc() || result.ptr != end) {
+        throw std::invalid_argument("not a number of " + std::to_string(8 * sizeof(ElementType)) + " bits: " +
+                                    std::string(begin, end));
+    }
+    return e;
+#else
+    throw std::invalid_argument("the numbers set file format needs elements of at most 64 bits");
+#endif
+}
+
+// Function to parse the lines in [begin, end) into elements, skipping empty lines
+void ParseLines(std::vector<ElementType> &elements, const char *begin, const char *end, SetFileFormat format) {
+    while (begin < end) {
+        auto newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+        const char *line_end = newline != nullptr ? newline : end;
+        const char *next = newline != nullptr ? newline + 1 : end;
+        // Files written on Windows end their lines with \r\n
+        if (line_end > begin && line_end[-1] == '\r') {
+            line_end--;
+        }
+        if (line_end > begin) {
+            if (format == SetFileFormat::numbers) {
+                elements.push_back(ParseNumber(begin, line_end));
+            } else {
+                elements.push_back(DigestElement(std::string_view(begin, line_end - begin)));
+            }
+        }
+        begin = next;
+    }
+}
+
+// Function to sort v on num_threads threads: the ranges of the threads are sorted in parallel, then merged pairwise
+void ParallelSort(std::vector<ElementType> &v, uint32 num_threads) {
+    // Below this many elements per range, sorting on one thread is faster than merging
+    const uint64 minRangeSize = 1 << 16;
+    uint64 ranges = std::clamp<uint64>(v.size() / minRangeSize, 1, std::max<uint32>(num_threads, 1));
+    std::vector<uint64> bounds(ranges + 1);
+    for (uint64 r = 0; r <= ranges; r++) {
+        bounds[r] = v.size() * r / ranges;
+    }
+    ParallelFor(ranges, num_threads, [&](uint64 begin, uint64 end) {
+        for (uint64 r = begin; r < end; r++) {
+            std::sort(v.begin() + bounds[r], v.begin() + bounds[r + 1]);
+        }
+    }, 1);
+    for (uint64 width = 1; width < ranges; width *= 2) {
+        uint64 pairs = (ranges + 2 * width - 1) / (2 * width);
+        ParallelFor(pairs, num_threads, [&](uint64 begin, uint64 end) {
+            for (uint64 i = begin; i < end; i++) {
+                uint64 first = 2 * width * i;
+                uint64 middle = std::min(first + width, ranges), last = std::min(first + 2 * width, ranges);
+                std::inplace_merge(v.begin() + bounds[first], v.begin() + bounds[middle], v.begin() + bounds[last]);
+            }
+        }, 1);
+    }
+}
+
+} // namespace
+
+// Function to load a set from a file in the given format, parsing and removing duplicates on num_threads threads
+void LoadSet(std::vector<ElementType> &set, const std::string &path, SetFileFormat format, uint32 num_threads,
+             SetLoadStatistics *statistics) {
+    SetLoadStatistics local_statistics;
+    SetLoadStatistics &stats = statistics != nullptr ? *statistics : local_statistics;
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file(path);
+    stats.bytes = file.size();
+    auto mapped = std::chrono::steady_clock::now();
+    stats.map_seconds = std::chrono::duration<double>(mapped - start).count();
+
+    set.clear();
+    num_threads = std::max<uint32>(num_threads, 1);
+    if (format == SetFileFormat::binary) {
+        // Records are copied straight from the mapping into the set
+        if (file.size() % sizeof(ElementType) != 0) {
+            throw std::invalid_argument(path + " is not a whole number of " + std::to_string(sizeof(ElementType)) +
+                                        "-byte elements");
+        }
+        set.resize(file.size() / sizeof(ElementType));
+        ParallelFor(set.size(), num_threads, [&](uint64 begin, uint64 end) {
+            std::memcpy(set.data() + begin, file.data() + begin * sizeof(ElementType),
+                        (end - begin) * sizeof(ElementType));
+        }, 1 << 16);
+    } else {
+        // Every thread takes the lines starting in its part of the file
+        const char *data = file.data();
+        uint64 parts = std::max<uint64>(std::min<uint64>(num_threads, file.size() / (1 << 16)), 1);
+        std::vector<uint64> bounds(parts + 1, file.size());
+        bounds[0] = 0;
+        for (uint64 p = 1; p < parts; p++) {
+            // The part starts at the first line beginning at or after from
+            uint64 from = std::max(file.size() * p / parts, bounds[p - 1]);
+            auto newline = static_cast<const char *>(std::memchr(data + from - 1, '\n', file.size() - from + 1));
+            bounds[p] = newline != nullptr ? newline + 1 - data : file.size();
+        }
+
+        std::vector<std::vector<ElementType>> part_elements(parts);
+        std::vector<std::exception_ptr> errors(parts);
+        ParallelFor(parts, num_threads, [&](uint64 begin, uint64 end) {
+            for (uint64 p = begin; p < end; p++) {
+                try {
+                    ParseLines(part_elements[p], data + bounds[p], data + bounds[p + 1], format);
+                } catch (...) {
+                    errors[p] = std::current_exception();
+                }
+            }
+        }, 1);
+        for (const auto &error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        std::vector<uint64> offsets(parts + 1, 0);
+        for (uint64 p = 0; p < parts; p++) {
+            offsets[p + 1] = offsets[p] + part_elements[p].size();
+        }
+        set.resize(offsets[parts]);
+        ParallelFor(parts, num_threads, [&](uint64 begin, uint64 end) {
+            for (uint64 p = begin; p < end; p++) {
+                std::copy(part_elements[p].begin(), part_elements[p].end(), set.begin() + offsets[p]);
+                std::vector<ElementType>().swap(part_elements[p]);
+            }
+        }, 1);
+    }
+    stats.records = set.size();
+    auto parsed = std::chrono::steady_clock::now();
+    stats.parse_seconds = std::chrono::duration<double>(parsed - mapped).count();
+
+    ParallelSort(set, num_threads);
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+    stats.elements = set.size();
+    stats.deduplicate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parsed).count();
+}
+
+// Function to get the set of a party, loaded from the set file of the configuration if there is one and generated
+// otherwise
+void GetElementSet(std::vector<ElementType> &set, const ExperimentConfig &config) {
+    if (config.set_file.empty()) {
+        set.reserve(config.element_set_size);
+        generate_set(set, config);
+        return;
+    }
+
+    SetLoadStatistics stats;
+    LoadSet(set, config.set_file, config.set_file_format, config.options.num_threads, &stats);
+    double seconds = stats.map_seconds + stats.parse_seconds + stats.deduplicate_seconds;
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3) << config.options.local_name << " loaded " << stats.elements
+       << " elements (" << stats.records << " records, " << FormatBytes(stats.bytes) << ") from " << config.set_file
+       << " in " << seconds << " s: map " << stats.map_seconds << " s, parse " << stats.parse_seconds
+       << " s, deduplicate " << stats.deduplicate_seconds << " s, " << std::setprecision(2)
+       << stats.records / std::max(seconds, 1e-9) / 1e6 << " M records/s";
+    std::cout << ss.str() << std::endl;
+}
@@ -2,10 +2,30 @@
 
 #include <NTL/ZZ.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include "third_party/smhasher/MurmurHash3.h"
+#include "utils/workload.h"
+
+// Seed of the digests of identifiers, the same for all parties
+const uint32 elementDigestSeed = 0;
+
+// Function to read the parameters of an emulated link, missing values are taken from defaults
+static LinkEmulation LinkEmulationFromJson(const nlohmann::json &cJson, const LinkEmulation &defaults) {
+    LinkEmulation link;
+    link.latency_ms = cJson.value("latencyMs", defaults.latency_ms);
+    link.jitter_ms = cJson.value("jitterMs", defaults.jitter_ms);
+    link.bandwidth_mbps = cJson.value("bandwidthMbps", defaults.bandwidth_mbps);
+    return link;
+}
+
 // Function to read an experiment configuration from a JSON file
 void NewConfigFromJsonFile(ExperimentConfig &config, const std::string &json_file) {
     // Read the JSON file into a string
@@ -20,19 +40,99 @@ void NewConfigFromJsonFile(ExperimentConfig &config, const std::string &json_fil
     config.options.bloom_filter_size = cJson["bloomFilterSize"].get<ContainerSizeType>();
     config.num_same_items = cJson["sameNum"].get<ContainerSizeType>();
     config.same_item_seed = cJson["sameSeed"].get<uint32>();
-    config.diff_item_seed = cJson["diffSeed"].get<uint32>();
     config.benchmark_rounds = cJson["benchmarkRounds"].get<uint32>();
+    if (cJson.contains("sharedElements")) {
+        for (const auto &cGroup: cJson["sharedElements"]) {
+            config.shared_elements.push_back({cGroup["parties"].get<std::vector<std::string>>(),
+                                              cGroup["count"].get<ContainerSizeType>()});
+        }
+    }
+    config.set_file = cJson.value("setFile", std::string());
+    auto set_file_format = cJson.value("setFileFormat", std::string("numbers"));
+    if (set_file_format == "binary") {
+        config.set_file_format = SetFileFormat::binary;
+    } else if (set_file_format == "numbers") {
+        config.set_file_format = SetFileFormat::numbers;
+    } else if (set_file_format == "identifiers") {
+        config.set_file_format = SetFileFormat::identifiers;
+    } else {
+        throw std::invalid_argument("unknown setFileFormat: " + set_file_format);
+    }
 
     config.options.num_parties = cJson["numberOfParties"].get<uint32>();
     config.options.intersection_threshold = cJson["threshold"].get<uint32>();
     config.options.num_hash_functions = cJson["numberOfHashFunctions"].get<uint32>();
     config.options.murmurhash_seeds = cJson["murmurhashSeeds"].get<std::vector<uint32>>();
+    auto bloom_filter_layout = cJson.value("bloomFilterLayout", std::string("seeded"));
+    if (bloom_filter_layout == "seeded") {
+        config.options.bloom_filter_layout = BloomFilterLayout::seeded;
+    } else if (bloom_filter_layout == "hashed") {
+        config.options.bloom_filter_layout = BloomFilterLayout::hashed;
+    } else if (bloom_filter_layout == "blocked") {
+        config.options.bloom_filter_layout = BloomFilterLayout::blocked;
+    } else {
+        throw std::invalid_argument("unknown bloomFilterLayout: " + bloom_filter_layout);
+    }
+    config.options.bloom_filter_block_bits = cJson.value("bloomFilterBlockBits", 512);
+    if (config.options.bloom_filter_block_bits == 0) {
+        throw std::invalid_argument("bloomFilterBlockBits must be positive");
+    }
+    // 0 threads means one per hardware thread
+    config.options.num_threads = cJson.value("numThreads", 0);
+    if (config.options.num_threads == 0) {
+        config.options.num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
     config.options.role = cJson["isServer"].get<bool>() ? Role::server : Role::client;
     config.options.port = cJson["port"].get<int>();
     config.options.local_name = cJson["localName"].get<std::string>();
     config.options.server_address = cJson["serverAddress"].get<std::string>();
     config.options.right_neighbor_address = cJson["rightNeighborAddress"].get<std::string>();
     config.options.party_list = cJson["allParties"].get<std::vector<std::string>>();
+    config.options.transport = cJson.value("transport", std::string("tcp"));
+    config.options.uring_zero_copy_threshold = cJson.value("uringZeroCopyThreshold", 1 << 16);
+    config.options.batch_size = cJson.value("batchSize", 256);
+    auto zz_format = cJson.value("zzFormat", std::string("fixed"));
+    if (zz_format == "fixed") {
+        config.options.zz_format = ZzFormat::fixed;
+    } else if (zz_format == "packed") {
+        config.options.zz_format = ZzFormat::packed;
+    } else {
+        throw std::invalid_argument("unknown zzFormat: " + zz_format);
+    }
+    if (config.options.batch_size == 0) {
+        throw std::invalid_argument("batchSize must be positive");
+    }
+
+    // Read the optional TCP options
+    if (cJson.contains("tcp")) {
+        const auto &cTcp = cJson["tcp"];
+        auto &tcp = config.options.tcp;
+        tcp.streams = cTcp.value("streams", tcp.streams);
+        tcp.stripe_bytes = cTcp.value("stripeBytes", tcp.stripe_bytes);
+        tcp.send_buffer_bytes = cTcp.value("sendBufferBytes", tcp.send_buffer_bytes);
+        tcp.receive_buffer_bytes = cTcp.value("receiveBufferBytes", tcp.receive_buffer_bytes);
+        tcp.no_delay = cTcp.value("noDelay", tcp.no_delay);
+        tcp.quick_ack = cTcp.value("quickAck", tcp.quick_ack);
+        if (tcp.streams == 0 || tcp.stripe_bytes == 0) {
+            throw std::invalid_argument("tcp streams and stripeBytes must be positive");
+        }
+    }
+    config.options.statistics_output = cJson.value("statisticsOutput", std::string());
+
+    // Read the optional network emulation, the links object overrides the parameters per remote name
+    if (cJson.contains("networkEmulation")) {
+        const auto &cEmulation = cJson["networkEmulation"];
+        auto &emulation = config.options.network_emulation;
+        emulation.enabled = true;
+        emulation.link = LinkEmulationFromJson(cEmulation, emulation.link);
+        emulation.buffer_bytes = cEmulation.value("bufferBytes", emulation.buffer_bytes);
+        emulation.seed = cEmulation.value("seed", emulation.seed);
+        if (cEmulation.contains("links")) {
+            for (const auto &[remote, cLink]: cEmulation["links"].items()) {
+                emulation.links[remote] = LinkEmulationFromJson(cLink, emulation.link);
+            }
+        }
+    }
 
     // Convert some values from strings to NTL::ZZ
     config.options.p = NTL::conv<NTL::ZZ>(cJson["p"].get<std::string>().c_str());
@@ -50,26 +150,28 @@ void NewConfigFromJsonFile(ExperimentConfig &config, const std::string &json_fil
 
 // Function to generate a set of elements
 void generate_set(std::vector<ElementType> &set, const ExperimentConfig &config) {
-    set.clear();
-    long random_num = 0;
-
-    // Generate the same elements using the same seed
-    NTL::SetSeed(NTL::conv<NTL::ZZ>(config.same_item_seed));
-    for (auto i = 0; i < config.num_same_items; i++) {
-        NTL::RandomBnd(random_num, elementTypeMax);
-        set.emplace_back(random_num);
-    }
+    WorkloadGenerator(config).Generate(set, config.options.num_threads);
+}
 
-    // Generate the different elements using the different seed
-    NTL::SetSeed(NTL::conv<NTL::ZZ>(config.diff_item_seed));
-    for (auto i = config.num_same_items; i < config.element_set_size; i++) {
-        NTL::RandomBnd(random_num, elementTypeMax);
-        set.emplace_back(random_num);
+// Function to seed the random generator of NTL from the random device of the system
+void SeedRandomGenerator() {
+    std::random_device device;
+    unsigned char seed[32];
+    for (auto &byte: seed) {
+        byte = static_cast<unsigned char>(device());
     }
-    assert(set.size() == config.element_set_size);
+    NTL::ZZ n;
+    NTL::ZZFromBytes(n, seed, sizeof(seed));
+    NTL::SetSeed(n);
+}
 
-    // Set the seed to the current time
-    NTL::SetSeed(NTL::conv<NTL::ZZ>((long) time(nullptr))); // TODO: uncomment this
+// Function to hash an identifier of any length to an element
+ElementType DigestElement(std::string_view identifier) {
+    uint64 digest[2];
+    MurmurHash3_x64_128(identifier.data(), static_cast<int>(identifier.size()), elementDigestSeed, digest);
+    ElementType e;
+    std::memcpy(&e, digest, sizeof(e));
+    return e;
 }
 
 // Helper method to format a number of bytes in a more readable form
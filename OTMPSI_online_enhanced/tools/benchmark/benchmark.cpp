@@ -1,10 +1,11 @@
 
-#include <cstdlib>
 #include <fstream>
+#include <thread>
 
 #include "protocol/participant.h"
 #include "third_party/smhasher/MurmurHash3.h"
 #include "utils/common.h"
+#include "utils/set_loader.h"
 #include "utils/utils.h"
 
 int main(int argc, char *argv[]) {
@@ -17,8 +18,8 @@ int main(int argc, char *argv[]) {
     assert(config.options.num_hash_functions < config.options.q);
 
     std::vector<ElementType> set;
-    set.reserve(config.element_set_size);
-    generate_set(set, config);
+    GetElementSet(set, config);
+    SeedRandomGenerator();
 
     std::vector<std::vector<long long>> durations;
     std::vector<uint64> data_send_amounts;
@@ -36,12 +37,13 @@ int main(int argc, char *argv[]) {
     participant.RingLatency(false);
     participant.RingLatency(true);
 
-    srand(time(0));
-    for (auto i = 0; i < config.benchmark_rounds; i++) {
+    for (uint32 i = 0; i < config.benchmark_rounds; i++) {
         config.same_item_seed += 1;
-        config.diff_item_seed += rand();
-        generate_set(set, config);
-        participant.ChangeElementSet(set);
+        // A set loaded from a file is the same in every round
+        if (config.set_file.empty()) {
+            generate_set(set, config);
+            participant.ChangeElementSet(set);
+        }
         participant.RingLatency(false);
         durations.emplace_back(participant.Execute(false));
     }
@@ -0,0 +1,74 @@
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "microbenchmark.h"
+#include "utils/bloom_filter.h"
+
+// Function to measure inserts and membership tests of the Bloom filter layouts, and their false positive rates.
+// Options: [--count <elements>] [--hashes <hash functions>] [--bits_per_element <bits>] [--block_bits <bits>]
+//          [--threads <threads>]
+int BloomBenchmark(const std::vector<std::string> &args) {
+    uint64 count = 1 << 20;
+    uint32 hashes = 10;
+    uint32 bits_per_element = 15;
+    uint32 block_bits = 512;
+    uint32 threads = 1;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--count") {
+            count = std::stoul(args[i + 1]);
+        } else if (args[i] == "--hashes") {
+            hashes = std::stoul(args[i + 1]);
+        } else if (args[i] == "--bits_per_element") {
+            bits_per_element = std::stoul(args[i + 1]);
+        } else if (args[i] == "--block_bits") {
+            block_bits = std::stoul(args[i + 1]);
+        } else if (args[i] == "--threads") {
+            threads = std::stoul(args[i + 1]);
+        } else {
+            std::cerr << "unknown option " << args[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937 gen(1);
+    std::vector<uint32> seeds(hashes);
+    for (auto &seed: seeds) {
+        seed = gen();
+    }
+    // Even elements are inserted, odd ones are only tested
+    std::vector<ElementType> elements(count), others(count);
+    for (uint64 i = 0; i < count; i++) {
+        elements[i] = NthElement(2 * i);
+        others[i] = NthElement(2 * i + 1);
+    }
+    ContainerSizeType size = count * bits_per_element;
+    std::cout << count << " elements, " << hashes << " hash functions, " << size << " bits, " << threads
+              << " threads" << std::endl;
+
+    const std::pair<const char *, BloomFilterLayout> layouts[] = {{"seeded",  BloomFilterLayout::seeded},
+                                                                  {"hashed",  BloomFilterLayout::hashed},
+                                                                  {"blocked", BloomFilterLayout::blocked}};
+    for (const auto &layout: layouts) {
+        BloomFilter bf(size, seeds, layout.second, block_bits);
+        auto start = std::chrono::steady_clock::now();
+        bf.InsertAll(elements, threads);
+        double insert_seconds = SecondsSince(start);
+
+        std::vector<uint8> found(count);
+        start = std::chrono::steady_clock::now();
+        bf.CheckAll(others, found, threads);
+        double check_seconds = SecondsSince(start);
+        uint64 false_positives = 0;
+        for (const auto &f: found) {
+            false_positives += f;
+        }
+
+        std::cout << std::left << std::setw(8) << layout.first << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << count / insert_seconds / 1e6 << " M inserts/s"
+                  << std::setw(10) << count / check_seconds / 1e6 << " M checks/s"
+                  << std::setprecision(6) << std::setw(12) << static_cast<double>(false_positives) / count
+                  << " false positive rate" << std::endl;
+    }
+    return 0;
+}
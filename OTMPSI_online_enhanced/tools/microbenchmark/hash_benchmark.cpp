@@ -0,0 +1,60 @@
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "microbenchmark.h"
+#include "utils/murmur_batch.h"
+
+// Function to measure the batch hash kernels against each other and check that they agree with the scalar one.
+// Options: [--count <elements>] [--rounds <rounds>]
+int HashBenchmark(const std::vector<std::string> &args) {
+    uint64 count = 1 << 20;
+    uint32 rounds = 10;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--count") {
+            count = std::stoul(args[i + 1]);
+        } else if (args[i] == "--rounds") {
+            rounds = std::stoul(args[i + 1]);
+        } else {
+            std::cerr << "unknown option " << args[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937 gen(1);
+    std::vector<ElementType> elements(count);
+    for (auto &e: elements) {
+        e = RandomElement(gen);
+    }
+    uint32 seed = gen();
+    std::cout << count << " elements, " << rounds << " rounds, best kernel " << HashKernelName(BestHashKernel())
+              << std::endl;
+
+    std::vector<uint64> expected_x86(count), expected_x64(2 * count), x86(count), x64(2 * count);
+    MurmurHash3_x86_128_Low64Batch(elements.data(), count, seed, expected_x86.data(), HashKernel::scalar);
+    MurmurHash3_x64_128_Batch(elements.data(), count, seed, expected_x64.data(), HashKernel::scalar);
+    for (auto kernel: {HashKernel::scalar, HashKernel::avx2, HashKernel::avx512}) {
+        if (static_cast<int>(kernel) > static_cast<int>(BestHashKernel())) {
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (uint32 r = 0; r < rounds; r++) {
+            MurmurHash3_x86_128_Low64Batch(elements.data(), count, seed, x86.data(), kernel);
+        }
+        double x86_seconds = SecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (uint32 r = 0; r < rounds; r++) {
+            MurmurHash3_x64_128_Batch(elements.data(), count, seed, x64.data(), kernel);
+        }
+        double x64_seconds = SecondsSince(start);
+
+        std::cout << std::left << std::setw(8) << HashKernelName(kernel) << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(10) << count * rounds / x86_seconds / 1e6 << " M x86_128/s"
+                  << std::setw(10) << count * rounds / x64_seconds / 1e6 << " M x64_128/s" << std::endl;
+        if (x86 != expected_x86 || x64 != expected_x64) {
+            std::cerr << HashKernelName(kernel) << " hashes differ from the scalar ones" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
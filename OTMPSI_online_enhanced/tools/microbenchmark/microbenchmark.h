@@ -0,0 +1,46 @@
+#ifndef OTMPSI_TOOLS_MICROBENCHMARK_H_
+#define OTMPSI_TOOLS_MICROBENCHMARK_H_
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/utils.h"
+
+// Function to measure the throughput of the number codec against BytesFromZZ and ZZFromBytes
+int CodecBenchmark(const std::vector<std::string> &args);
+
+// Function to measure inserts and membership tests of the Bloom filter layouts
+int BloomBenchmark(const std::vector<std::string> &args);
+
+// Function to measure the batch hash kernels
+int HashBenchmark(const std::vector<std::string> &args);
+
+// Function to draw an element of any width from gen
+inline ElementType RandomElement(std::mt19937 &gen) {
+    uint32 words[(sizeof(ElementType) + 3) / 4];
+    for (auto &word: words) {
+        word = gen();
+    }
+    ElementType e;
+    std::memcpy(&e, words, sizeof(e));
+    return e;
+}
+
+// Function to get the i-th of a sequence of distinct elements, digests are taken of the index
+inline ElementType NthElement(uint64 i) {
+    if constexpr (elementsAreDigests) {
+        return DigestElement(std::string_view(reinterpret_cast<const char *>(&i), sizeof(i)));
+    } else {
+        return static_cast<ElementType>(i);
+    }
+}
+
+// Function to get the seconds elapsed since start
+inline double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif // OTMPSI_TOOLS_MICROBENCHMARK_H_
@@ -0,0 +1,39 @@
+#ifndef OTMPSI_CRYPTO_ENCRYPTION_POOL_H_
+#define OTMPSI_CRYPTO_ENCRYPTION_POOL_H_
+
+#include <vector>
+
+#include "crypto/threshold_paillier.h"
+#include "utils/common.h"
+
+// Class for a pool of encryptions of zero, filled ahead of time on several threads and taken from when the
+// encryptions are needed. An encryption of zero is the randomness of an encryption alone, so it becomes an encryption
+// of a message m with one multiplication by g^m = 1 + m * n, which is how the pool serves encryptions of 1 as well.
+// The pool refers to the public key, which must outlive it.
+class EncryptionPool {
+public:
+    // Delete the default constructor
+    EncryptionPool() = delete;
+
+    // Constructor that takes the public key to encrypt with
+    explicit EncryptionPool(const PublicKey &public_key) : public_key_(public_key) {};
+
+    // Method to fill the pool up to count encryptions on num_threads threads. Every thread seeds the random generator
+    // of NTL, which is per thread, from the generator of the calling thread
+    void Fill(uint64 count, uint32 num_threads);
+
+    // Method to take count encryptions out of the pool into dest, which is resized to count. The numbers are swapped,
+    // not copied, throws if the pool holds fewer
+    void Take(std::vector<ZZ> &dest, uint64 count);
+
+    // Method to get the number of encryptions in the pool
+    [[nodiscard]] inline uint64 size() const { return encryptions_.size(); }
+
+    [[nodiscard]] inline const PublicKey &public_key() const { return public_key_; }
+
+private:
+    const PublicKey &public_key_;
+    std::vector<ZZ> encryptions_;
+};
+
+#endif // OTMPSI_CRYPTO_ENCRYPTION_POOL_H_
@@ -0,0 +1,31 @@
+#ifndef OTMPSI_CRYPTO_KEY_CACHE_H_
+#define OTMPSI_CRYPTO_KEY_CACHE_H_
+
+#include <string>
+
+#include "crypto/threshold_paillier.h"
+#include "utils/common.h"
+
+// Functions to cache the threshold Paillier keys on disk. All parties derive the keys from the same seed, which takes
+// a search for two safe primes and the table of n-th residues, so the first run stores them in a file named after the
+// seed and the parameters of the keys, and later runs map that file instead. After a header with the parameters, which
+// loading checks, the file holds the numbers of the keys, each prefixed with its length in bytes. A file is written
+// under a temporary name and renamed, so parties sharing the directory never read a partial one.
+
+// Function to get the path of the cache file of the keys with the given parameters in directory
+std::string KeyCachePath(const std::string &directory, uint32 seed, long key_length, long threshold_l,
+                         long parties_t);
+
+// Function to load keys from a cache file, returns false if there is no file or it holds keys with other parameters
+bool LoadKeys(Keys *keys, const std::string &path, uint32 seed, long key_length, long threshold_l, long parties_t);
+
+// Function to store keys in a cache file, throws if the file cannot be written
+void StoreKeys(const Keys &keys, const std::string &path, uint32 seed, long key_length);
+
+// Function to get the keys derived from seed: loaded from the cache in directory if they are there, otherwise
+// generated on num_threads threads and stored in it. An empty directory disables the cache. Generating the keys seeds
+// the random generator of NTL with seed, loading them does not touch it.
+void CachedKeyGen(Keys *keys, const std::string &directory, uint32 seed, long key_length, long threshold_l,
+                  long parties_t, uint32 num_threads);
+
+#endif // OTMPSI_CRYPTO_KEY_CACHE_H_
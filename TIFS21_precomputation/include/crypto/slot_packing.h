@@ -0,0 +1,43 @@
+#ifndef OTMPSI_CRYPTO_SLOT_PACKING_H_
+#define OTMPSI_CRYPTO_SLOT_PACKING_H_
+
+#include "crypto/threshold_paillier.h"
+#include "utils/common.h"
+
+// Class for packing small plaintexts into the slots of one Paillier plaintext, so that one threshold decryption
+// reveals many of them. The ciphertexts of values v_0, ..., v_{s-1} pack into Enc(sum_i v_i * 2^(i * w)), built by
+// Horner's rule: the packed ciphertext is shifted by a slot, a homomorphic multiplication by 2^w, and the next value is
+// added. Values lie in [-bound, bound]. After decryption bound is added to every slot, each slot then holds a number in
+// [0, 2 * bound], below 2^w with a guard bit to spare, and the values are split off without carries. The absolute
+// value of the packed plaintext stays below n / 2, so a negative one decrypts to the negative number it is.
+class SlotPacking {
+public:
+    // Delete the default constructor
+    SlotPacking() = delete;
+
+    // Constructor that takes the bound of the absolute values and the public key they are encrypted under
+    SlotPacking(const ZZ &bound, const PublicKey &public_key);
+
+    // Method to get the number of values one ciphertext holds
+    [[nodiscard]] inline long slots() const { return slots_; }
+
+    // Method to get the number of bits of a slot
+    [[nodiscard]] inline long slot_bits() const { return slot_bits_; }
+
+    // Method to get the number of packed ciphertexts count values take
+    [[nodiscard]] inline uint64 PackedCount(uint64 count) const { return (count + slots_ - 1) / slots_; }
+
+    // Method to pack the ciphertexts of count values, at most slots, into dest
+    void PackInto(ZZ &dest, const ZZ *ciphertexts, long count, PaillierContext &paillier) const;
+
+    // Method to split the decrypted plaintext of count packed values into values
+    void Unpack(ZZ *values, const ZZ &plaintext, long count) const;
+
+private:
+    ZZ bound_;
+    long slot_bits_;
+    long slots_;
+    ZZ shift_; // 2^slot_bits_
+};
+
+#endif // OTMPSI_CRYPTO_SLOT_PACKING_H_
@@ -5,11 +5,48 @@
 #ifndef THRESHOLD_PAILLIER_H
 #define THRESHOLD_PAILLIER_H
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <NTL/ZZ.h>
 
 using namespace NTL;
 
+// Factorization of n and the constants to compute modulo n^2 by the Chinese remainder theorem: exponentiations are
+// done modulo p^2 and q^2, with exponents reduced modulo phi(p^2) and phi(q^2), and then recombined
+struct CrtParameters {
+    ZZ p;
+    ZZ q;
+    ZZ p_squared;
+    ZZ q_squared;
+    ZZ phi_p_squared; // p * (p - 1)
+    ZZ phi_q_squared; // q * (q - 1)
+    ZZ q_squared_inverse; // q^2 ^ -1 mod p^2
+};
+
+// Table to draw the randomness r^n of encryptions as h^a, for a fixed n-th residue h and short random exponents a,
+// by fixed-base exponentiation: a is split into windows and the table holds h raised to every value of every window,
+// so h^a takes one multiplication per window. The randomness is then no longer uniform over the n-th residues, its
+// hiding relies on the short exponent assumption of Damgard, Jurik and Nielsen.
+struct NthResidueTable {
+    long exponent_bits; // number of bits of a
+    long window_bits; // number of bits of a window
+    std::vector<std::vector<ZZ>> powers; // powers[k][j] = h^(j * 2^(k * window_bits)) mod n^2
+};
+
+// Cache of the Lagrange coefficients that combine partial decryptions, per list of share indices. The same parties
+// combine every ciphertext, so the coefficients are computed once per list.
+class LagrangeCache {
+public:
+    // Method to get the coefficients delta * lambda_i of the shares with the given indices, in the same order
+    const std::vector<ZZ>& Coefficients(const std::vector<long>& indices, const ZZ& delta);
+
+private:
+    std::mutex mutex_;
+    std::map<std::vector<long>, std::vector<ZZ>> coefficients_;
+};
+
 struct PublicKey {
     ZZ g;
     ZZ n;
@@ -17,6 +54,13 @@ struct PublicKey {
     ZZ theta;
     ZZ delta;
     long threshold_l;
+    // All parties derive the keys from the same seed and thus know the factorization, if set the operations modulo
+    // n^2 use it
+    std::shared_ptr<const CrtParameters> crt;
+    // If set, the randomness of encryptions is drawn from it
+    std::shared_ptr<const NthResidueTable> nth_residues;
+    ZZ combine_inverse; // (4 * delta^2 * theta)^-1 mod n
+    std::shared_ptr<LagrangeCache> lagrange;
 };
 
 struct Keys {
@@ -24,14 +68,68 @@ struct Keys {
     std::vector<ZZ> private_keys;
 };
 
-void key_gen(Keys* keys, long key_length, long threshold_l, long parties_t);
-ZZ encrypt(ZZ message, const PublicKey& public_key);
-ZZ partial_decrypt(ZZ& ciphertext, const PublicKey& public_key, ZZ& secret_key);
-ZZ combine_partial_decrypt(std::vector<std::pair<long, ZZ>> secret_shares, const PublicKey& public_key);
-ZZ add_homomorphically(ZZ c1, ZZ c2, PublicKey& public_key);
-ZZ subtract_homomorphically(ZZ c1, ZZ c2, PublicKey& public_key);
-ZZ multiply_homomorphically(ZZ ciphertext, ZZ scalar, PublicKey& public_key);
-ZZ rerandomize(ZZ ciphertext, PublicKey& public_key);
+// Class for Paillier operations in place: results are written into existing numbers, which keep their storage, and
+// intermediate values live in scratch numbers of the context, so loops over ciphertexts do not allocate once the
+// numbers have grown to the size of n^2. Results may alias arguments. A context is not thread-safe, every thread needs
+// its own, and it refers to the public key, which must outlive it.
+class PaillierContext {
+public:
+    // Delete the default constructor
+    PaillierContext() = delete;
+
+    // Constructor that takes the public key to compute with
+    explicit PaillierContext(const PublicKey& public_key) : public_key_(public_key) {};
+
+    [[nodiscard]] const PublicKey& public_key() const { return public_key_; };
+
+    // Method to encrypt a message: dest = Enc(message)
+    void EncryptInto(ZZ& dest, const ZZ& message);
+
+    // Method to add two ciphertexts: dest = Enc(a + b)
+    void AddInto(ZZ& dest, const ZZ& a, const ZZ& b) const;
+
+    // Method to subtract two ciphertexts: dest = Enc(a - b)
+    void SubtractInto(ZZ& dest, const ZZ& a, const ZZ& b);
+
+    // Method to negate count ciphertexts at once: dest[i] = Enc(-a[i]), with a single inversion
+    void NegateBatchInto(ZZ* dest, const ZZ* a, long count);
+
+    // Method to multiply a ciphertext by a scalar: dest = Enc(a * scalar)
+    void MultiplyInto(ZZ& dest, const ZZ& a, const ZZ& scalar);
+
+    // Method to rerandomize a ciphertext: dest = a + Enc(0)
+    void RerandomizeInto(ZZ& dest, const ZZ& a);
+
+    // Method to partially decrypt a ciphertext with the share of the secret key of a party
+    void PartialDecryptInto(ZZ& dest, const ZZ& ciphertext, const ZZ& secret_key);
+
+    // Method to draw the randomness of an encryption, an n-th residue modulo n^2 distributed as r^n for a random r
+    void UniformNthResidueInto(ZZ& dest);
+
+private:
+    const PublicKey& public_key_;
+
+    // Scratch numbers
+    ZZ base_p_, base_q_, exponent_p_, exponent_q_, difference_;
+    ZZ exponent_, residue_, residue_exponent_, message_, inverse_;
+    std::vector<ZZ> products_;
+
+    void PowerModInto(ZZ& dest, const ZZ& base, const ZZ& exponent);
+    void RandomNthResidueInto(ZZ& dest);
+};
+
+// Function to compute the CRT parameters of n = p * q
+std::shared_ptr<const CrtParameters> make_crt_parameters(const ZZ& p, const ZZ& q);
+
+// Function to generate the keys, the safe primes are searched for on num_threads threads and do not depend on it
+void key_gen(Keys* keys, long key_length, long threshold_l, long parties_t, long num_threads = 1);
+ZZ encrypt(const ZZ& message, const PublicKey& public_key);
+ZZ partial_decrypt(const ZZ& ciphertext, const PublicKey& public_key, const ZZ& secret_key);
+ZZ combine_partial_decrypt(const std::vector<std::pair<long, ZZ>>& secret_shares, const PublicKey& public_key);
+ZZ add_homomorphically(const ZZ& c1, const ZZ& c2, const PublicKey& public_key);
+ZZ subtract_homomorphically(const ZZ& c1, const ZZ& c2, const PublicKey& public_key);
+ZZ multiply_homomorphically(const ZZ& ciphertext, const ZZ& scalar, const PublicKey& public_key);
+ZZ rerandomize(const ZZ& ciphertext, const PublicKey& public_key);
 ZZ Gen_Coprime(const NTL::ZZ& n);
 
 #endif //THRESHOLD_PAILLIER_H
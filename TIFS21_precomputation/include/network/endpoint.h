@@ -3,6 +3,7 @@
 
 #include <string>
 
+#include "traffic_stats.h"
 #include "utils/common.h"
 
 // Abstract base class for network endpoints
@@ -24,6 +25,9 @@ public:
     virtual void
     Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) = 0;
 
+    // Method to block until at least num_connections remote endpoints are connected
+    virtual void WaitForConnections(uint32 num_connections);
+
     // Method to close a connection with a remote endpoint
     virtual void CloseChannel(const std::string &remote_name) = 0;
 
@@ -40,13 +44,26 @@ public:
     virtual std::vector<std::string> GetRemoteNames() = 0;
 
     // Method to get the total amount of data sent in a more readable form
-    virtual uint64 GetTotalBytesSent() const = 0;
+    [[nodiscard]] inline uint64 GetTotalBytesSent() const { return stats_.total_bytes_sent(); }
 
     // Method to get the total amount of data received in a more readable form
-    virtual uint64 GetTotalBytesReceived() const = 0;
+    [[nodiscard]] inline uint64 GetTotalBytesReceived() const { return stats_.total_bytes_received(); }
 
     // Method to reset the total amount of data sent and received
-    virtual void ResetCounters() = 0;
+    inline void ResetCounters() { stats_.ResetTotals(); }
+
+    // Method to attribute subsequent traffic to a protocol phase
+    inline void SetPhase(const std::string &phase) { stats_.SetPhase(phase); }
+
+    // Method to get the traffic per protocol phase and remote endpoint as JSON
+    [[nodiscard]] inline nlohmann::json GetStatistics() const { return stats_.ToJson(); }
+
+protected:
+    // Traffic counters, updated by the implementations on every read and write
+    TrafficStats stats_;
 };
 
+// Function to create the endpoint selected by the transport option, wrapped into an emulated network if enabled
+Endpoint *NewEndpoint(const Options &options);
+
 #endif // OTMPSI_NETWORK_ENDPOINT_H_
@@ -0,0 +1,154 @@
+#ifndef OTMPSI_NETWORK_MEMORYENDPOINT_H_
+#define OTMPSI_NETWORK_MEMORYENDPOINT_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "endpoint.h"
+
+class MemoryEndpoint;
+
+// Class for one direction of an in-memory channel
+struct MemoryLink {
+    // A message waiting to be read, owned by the link
+    struct Chunk {
+        uint8 *data;
+        uint32 len;
+        uint32 offset;
+    };
+
+    std::deque<Chunk> chunks; // messages written before the reader asked for them
+    uint8 *pending_read = nullptr; // destination of a blocked reader, filled in place by the writer
+    uint32 pending_len = 0; // number of bytes the blocked reader still needs
+
+    // Destructor that frees the messages never read
+    ~MemoryLink();
+};
+
+// Class connecting the in-memory endpoints of all participants running in one process. All links are
+// guarded by one mutex. In deterministic mode only one participant thread runs at a time, and the turn is
+// handed to the next runnable participant in a fixed round-robin order whenever the running one blocks.
+// If a participant fails, or every participant is blocked, the failure is recorded and all blocked
+// participants throw, so that their threads unwind and the thread joining them can rethrow the failure.
+class MemoryNetwork {
+public:
+    // Delete the default constructor
+    MemoryNetwork() = delete;
+
+    // Constructor that takes whether participants are scheduled deterministically
+    explicit MemoryNetwork(bool deterministic) : deterministic_(deterministic) {};
+
+    // Method to register an endpoint under its listening port, returns the scheduling id of the endpoint
+    uint32 Register(uint32 port, MemoryEndpoint *endpoint);
+
+    // Method to find the endpoint listening on a port
+    MemoryEndpoint *Lookup(uint32 port);
+
+    // Method to wait for the turn of a participant thread before it starts running
+    void Enter(uint32 id);
+
+    // Method to hand the turn over when a participant thread has finished
+    void Leave(uint32 id);
+
+    // Method to block the calling participant until a condition holds, the lock must be held by the caller
+    void Block(std::unique_lock<std::mutex> &lock, uint32 id, const std::function<bool()> &ready);
+
+    // Method to wake up blocked participants after a link changed, the lock must be held by the caller
+    inline void Notify() { cv_.notify_all(); }
+
+    // Method to record the failure of a participant thread and wake up the others, only the first one is kept
+    void Fail(std::exception_ptr failure);
+
+    // Method to get the first failure recorded, null if no participant failed
+    std::exception_ptr failure();
+
+    // Mutex guarding all links of the network
+    std::mutex mtx_;
+
+private:
+    // Method to pass the turn to the next runnable participant after id, records a failure if there is none
+    void PassTurn(uint32 id);
+
+    // Method to throw in a participant that was woken up by the failure of another, the lock must be held
+    void ThrowIfFailed() const;
+
+    bool deterministic_;
+    std::condition_variable cv_;
+    std::map<uint32, MemoryEndpoint *> endpoints_; // endpoints by listening port
+    std::vector<std::function<bool()>> blocked_; // per participant, the condition it waits for
+    std::vector<bool> finished_; // per participant, whether it has left
+    uint32 running_ = 0; // participant holding the turn in deterministic mode
+    std::exception_ptr failure_; // first failure of a participant, or the deadlock of all of them
+};
+
+// Class for an in-memory endpoint. Writes are handed directly to a blocked reader or queued as a single copy,
+// asynchronous writes hand the buffer itself over without copying.
+class MemoryEndpoint : public Endpoint {
+public:
+    // Delete the default constructor
+    MemoryEndpoint() = delete;
+
+    // Default destructor
+    ~MemoryEndpoint() override = default;
+
+    // Constructor that registers the endpoint in the network under its listening port
+    MemoryEndpoint(MemoryNetwork &network, uint32 port) : network_(network), id_(network.Register(port, this)) {};
+
+    // Method to get the scheduling id of the endpoint
+    [[nodiscard]] inline uint32 id() const { return id_; }
+
+    // Method to start the endpoint
+    void Start() override {};
+
+    // Method to stop the endpoint
+    void Stop() override;
+
+    // Method to stop listen
+    void StopListen() override {};
+
+    // Method to connect to a remote endpoint
+    void
+    Connect(const std::string &remote_name, const std::string &remote_address, const std::string &local_name) override;
+
+    // Method to block until at least num_connections remote endpoints are connected
+    void WaitForConnections(uint32 num_connections) override;
+
+    // Method to close a connection with a remote endpoint
+    void CloseChannel(const std::string &remote_name) override;
+
+    // Method to write data to a remote endpoint
+    void Write(const std::string &remote_name, const void *buf, uint32 len) override;
+
+    // Method to asynchronously write data to a remote endpoint, the buffer is handed over and freed once read
+    void AsyncWrite(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to read data from a remote endpoint
+    void Read(const std::string &remote_name, void *buf, uint32 len) override;
+
+    // Method to get the names of all connected remote endpoints
+    std::vector<std::string> GetRemoteNames() override;
+
+private:
+    // Both directions of a channel, shared with the remote endpoint
+    struct Channel {
+        std::shared_ptr<MemoryLink> out;
+        std::shared_ptr<MemoryLink> in;
+    };
+
+    // Method to deliver a message on a link, taking ownership of data if owned is set, the lock must be held
+    void Deliver(MemoryLink &link, const uint8 *data, uint32 len, bool owned);
+
+    MemoryNetwork &network_;
+    uint32 id_;
+    std::unordered_map<std::string, Channel> channels_;
+};
+
+#endif // OTMPSI_NETWORK_MEMORYENDPOINT_H_
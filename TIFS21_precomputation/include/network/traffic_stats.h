@@ -0,0 +1,81 @@
+#ifndef OTMPSI_NETWORK_TRAFFICSTATS_H_
+#define OTMPSI_NETWORK_TRAFFICSTATS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/common.h"
+
+// Maximum number of protocol phases the traffic statistics distinguish, the setup phase included
+const int maxTrafficPhases = 16;
+
+// Name of the phase traffic is attributed to before any phase is set
+const std::string setupPhaseName = "Setup";
+
+// Struct for the traffic counters of one remote endpoint in one phase
+struct TrafficCounters {
+    std::atomic<uint64> bytes_sent{0};
+    std::atomic<uint64> bytes_received{0};
+    std::atomic<uint64> messages_sent{0};
+    std::atomic<uint64> messages_received{0};
+    std::atomic<uint64> syscalls{0}; // system calls made to move the data, including waits
+    std::atomic<uint64> write_blocked_ns{0}; // time spent inside Write
+    std::atomic<uint64> read_blocked_ns{0}; // time spent inside Read
+};
+
+// Class for the traffic statistics of an endpoint, per remote endpoint and per protocol phase. Recording takes the
+// lock shared to look the remote endpoint up and then adds to atomic counters, the lock is only taken exclusively
+// when a phase is set or a remote endpoint is seen for the first time.
+class TrafficStats {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Default constructor, starts in the setup phase
+    TrafficStats() : phases_{setupPhaseName} {};
+
+    // Method to attribute subsequent traffic to a phase, registering the phase on first use. Throws if a new phase
+    // is set when maxTrafficPhases phases are registered
+    void SetPhase(const std::string &phase);
+
+    // Method to record a message written to a remote endpoint
+    void RecordWrite(const std::string &remote_name, uint64 bytes, uint64 syscalls, Clock::time_point start);
+
+    // Method to record a message read from a remote endpoint
+    void RecordRead(const std::string &remote_name, uint64 bytes, uint64 syscalls, Clock::time_point start);
+
+    // Method to get the counters per phase and remote endpoint as JSON
+    [[nodiscard]] nlohmann::json ToJson() const;
+
+    // Method to get the total amount of data sent since the last reset
+    [[nodiscard]] inline uint64 total_bytes_sent() const { return total_bytes_sent_; }
+
+    // Method to get the total amount of data received since the last reset
+    [[nodiscard]] inline uint64 total_bytes_received() const { return total_bytes_received_; }
+
+    // Method to reset the totals, the per-phase counters accumulate over the lifetime of the endpoint
+    inline void ResetTotals() {
+        total_bytes_sent_ = 0;
+        total_bytes_received_ = 0;
+    }
+
+private:
+    typedef std::array<TrafficCounters, maxTrafficPhases> PhaseCounters;
+
+    // Method to get the counters of a remote endpoint in the current phase
+    TrafficCounters &counters(const std::string &remote_name);
+
+    mutable std::shared_mutex mtx_;
+    std::vector<std::string> phases_;
+    std::atomic<int> phase_{0};
+    std::unordered_map<std::string, std::unique_ptr<PhaseCounters>> remotes_;
+    std::atomic<uint64> total_bytes_sent_{0};
+    std::atomic<uint64> total_bytes_received_{0};
+};
+
+#endif // OTMPSI_NETWORK_TRAFFICSTATS_H_
@@ -2,21 +2,29 @@
 #define OTMPSI_PARTICIPANT_H
 
 #include <chrono>
+#include <memory>
 #include <vector>
 
+#include "crypto/encryption_pool.h"
+#include "crypto/slot_packing.h"
 #include "crypto/threshold_paillier.h"
-#include "network/tcp_endpoint.h"
+#include "network/endpoint.h"
 #include "utils/bloom_filter.h"
 #include "utils/common.h"
+#include "utils/zz_codec.h"
 
 class Participant {
 public:
     Participant(const Options &options, const std::vector<ElementType> &set)
-            : endpoint_(new TcpEndpoint(options.port)),
+            : Participant(options, set, NewEndpoint(options)) {};
+
+    Participant(const Options &options, const std::vector<ElementType> &set, Endpoint *endpoint)
+            : endpoint_(endpoint),
               elements_(set),
               bf_(options.bloom_filter_size, options.num_hash_functions),
               options_(options),
-              index_(options.index){
+              index_(options.index),
+              codec_(options.num_bytes_field_numbers, options.zz_format) {
         endpoint_->Start();
     };
 
@@ -46,16 +54,23 @@ private:
     BloomFilter bf_;
     Options options_;
     Keys keys_;
+    std::unique_ptr<PaillierContext> paillier_; // context of the keys, for the operations of the protocol
+    std::unique_ptr<EncryptionPool> encryption_pool_; // encryptions of zero the client encrypts its Bloom filter with
+    std::unique_ptr<SlotPacking> comparison_packing_; // packing of the c of SCPs, decrypted to compare them with 0
+    std::unique_ptr<SlotPacking> indicator_packing_; // packing of the final indicators of the server's elements
     uint32 index_;
+    ZzCodec codec_;
+    std::vector<uint8> wire_buffer_;
 
     std::vector<ZZ> ebf_;
     std::vector<ZZ> one_encryptions_;
     std::vector<ZZ> zero_encryptions_;
     std::vector<ZZ> k_encryptions_;
     std::vector<ZZ> l_encryptions_;
-    std::vector<ZZ> r_array_;
-    std::vector<ZZ> r_prime_array_;
-    std::vector<ZZ> r_prime_encrpytions_;
+    std::vector<ZZ> r_array_; // r of the SCPs, of the client's negated if b = 1
+    std::vector<ZZ> offset_encryptions_; // Enc((2b - 1) * r') of the client's SCPs
+    std::vector<uint8> swaps_; // b of the client's SCPs, a_1 and a_2 are swapped if it is 1
+    std::vector<ZZ> negated_r_prime_encryptions_; // Enc(-r') of the server's SCPs
     std::vector<ZZ> rerands_;
     uint32 rerand_count_;
     uint32 scp_count_;
@@ -64,6 +79,8 @@ private:
 
     void InitializeClient();
 
+    void InitializePackings();
+
     void PrecomputeServer();
     void PrecomputeClient();
 
@@ -71,17 +88,29 @@ private:
 
     void ExecuteClient();
 
-    ZZ ScpServer(ZZ a, ZZ b);
-    void ScpClient();
+    void ScpServer(std::vector<NTL::ZZ> &values, const std::vector<NTL::ZZ> &constants, std::vector<NTL::ZZ> &a_1,
+                   std::vector<NTL::ZZ> &a_2, std::vector<const NTL::ZZ *> &comparisons);
+    void ScpClient(uint64 count);
 
     inline void SendZz(const std::string &remote, const NTL::ZZ &n);
 
     inline void ReceiveZz(const std::string &remote, NTL::ZZ &n);
 
+    void SendZzBatch(const std::string &remote, const NTL::ZZ *numbers, uint64 count);
+
+    void ReceiveZzBatch(const std::string &remote, NTL::ZZ *numbers, uint64 count);
+
     void BroadcastZz(const NTL::ZZ &n);
 
+    void DecryptPacked(const SlotPacking &packing, const NTL::ZZ *ciphertexts, uint64 count,
+                       std::vector<NTL::ZZ> &values);
+
+    void DecryptPackedClient(const SlotPacking &packing, uint64 count);
+
     void CollectZz(std::vector<NTL::ZZ> &zz_array);
 
+    void WriteStatistics() const;
+
     void RingLatencyServer(std::chrono::high_resolution_clock::time_point start, bool print);
 
     void RingLatencyClient();
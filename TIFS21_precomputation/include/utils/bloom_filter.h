@@ -5,29 +5,38 @@
 #ifndef BLOOM_FILTER_H
 #define BLOOM_FILTER_H
 
+#include <cstdint>
 #include <vector>
+#include "crypto/encryption_pool.h"
 #include "crypto/threshold_paillier.h"
 #include "third_party/smhasher/MurmurHash3.h"
+#include "utils/common.h"
 
 using namespace NTL;
 
 class BloomFilter {
 public:
     explicit BloomFilter(unsigned long m_bits, unsigned long k_hashes) :
-            storage(m_bits),
+            storage((m_bits + 63) / 64),
             m_bits(m_bits),
             k_hashes(k_hashes) {}
 
     void insert(long element);
     bool contains(long element);
+    void insert_all(const std::vector<ElementType> &elements, unsigned int num_threads = 1);
+    void contains_all(const std::vector<ElementType> &elements, std::vector<uint8> &found,
+                      unsigned int num_threads = 1) const;
     void invert();
-    void encrypt_all(std::vector<ZZ> &ciphertexts, PublicKey &public_key);
+    void encrypt_all(std::vector<ZZ> &ciphertexts, EncryptionPool &pool, unsigned int num_threads = 1);
     static unsigned long hash(long input, long seed);
 
     void clear();
 
 private:
-    std::vector<bool> storage;  // TODO: Make private
+    bool get(unsigned long index) const;
+    void set(unsigned long index, bool concurrent);
+
+    std::vector<uint64_t> storage;  // 64 bits to a word, the bits past m_bits stay 0
     unsigned long m_bits;
     unsigned long k_hashes;
 };
@@ -3,6 +3,7 @@
 
 #include <NTL/ZZ.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -32,6 +33,38 @@ enum Role {
     server = 1,
 };
 
+// Enum for the wire format of batches of numbers
+enum class ZzFormat {
+    fixed = 0, // every number takes the same number of bytes
+    packed = 1, // every number is prefixed with its length, leading zero bytes are dropped
+};
+
+// Struct for storing the parameters of an emulated network link
+struct LinkEmulation {
+    double latency_ms = 0; // one-way latency
+    double jitter_ms = 0; // maximum deviation from the latency, drawn uniformly
+    double bandwidth_mbps = 0; // bandwidth cap, 0 for no cap
+};
+
+// Struct for storing the network emulation options
+struct NetworkEmulation {
+    bool enabled = false; // wrap the endpoint into an emulated network
+    LinkEmulation link; // parameters of every link
+    std::map<std::string, LinkEmulation> links; // parameters overridden per remote name
+    uint64 buffer_bytes = 1 << 22; // bytes a link queues before writes block
+    uint64 seed = 0; // seed of the jitter
+};
+
+// Struct for storing the options of TCP channels
+struct TcpOptions {
+    uint32 streams = 1; // parallel TCP connections per channel, data is striped across them
+    uint32 stripe_bytes = 1 << 16; // bytes sent on one connection before moving to the next
+    int send_buffer_bytes = 0; // SO_SNDBUF of every connection, 0 keeps the kernel's autotuning
+    int receive_buffer_bytes = 0; // SO_RCVBUF of every connection, 0 keeps the kernel's autotuning
+    bool no_delay = false; // disable Nagle's algorithm
+    bool quick_ack = false; // acknowledge immediately instead of delaying, re-armed after every receive
+};
+
 // Struct for storing options for the protocol
 struct Options {
     uint32 num_parties; // number of parties
@@ -48,18 +81,34 @@ struct Options {
     std::string right_neighbor_address; // address of right neighbor on the ring
     std::vector<std::string> party_list; // all parties' name
     uint32 num_bytes_field_numbers; // number of bytes for numbers belongs to prime field p_
+    std::string transport; // transport between parties, "tcp", "uring" for TCP through io_uring, or "shm"
+    uint32 uring_zero_copy_threshold; // smallest send the io_uring transport makes without copying, 0 disables
+    TcpOptions tcp; // streams and socket options of TCP channels
+    ZzFormat zz_format; // wire format of batches of numbers
+    uint32 batch_size; // number of values sent in one message where the protocol sends them in batches
+    uint32 num_threads; // threads for the parts of the protocol that run in parallel
+    NetworkEmulation network_emulation; // emulated latency, jitter and bandwidth of the links
+    std::string statistics_output; // file the traffic statistics are written to after every execution, if set
 
     uint32 keys_seed;
+    std::string key_cache_dir; // directory the keys derived from keys_seed are cached in, no cache if empty
     uint32 index;
 };
 
+// Struct for a group of parties that share elements
+struct SharedElements {
+    std::vector<std::string> parties; // names of the parties sharing the elements
+    ContainerSizeType count; // number of elements all of them hold
+};
+
 // Struct for storing experiment configuration
 struct ExperimentConfig {
     ContainerSizeType element_set_size;
     ContainerSizeType num_same_items;
     uint32 same_item_seed;
-    uint32 diff_item_seed;
     uint32 benchmark_rounds;
+    std::vector<SharedElements> shared_elements; // groups sharing elements, if empty the parties share prefixes of
+                                                 // one common sequence, num_same_items long
 
     Options options;
 };
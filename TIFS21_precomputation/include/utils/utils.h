@@ -9,6 +9,10 @@ void NewConfigFromJsonFile(ExperimentConfig &config, const std::string &json_fil
 // Function to generate a set of elements
 void generate_set(std::vector<ElementType> &set, const ExperimentConfig &config);
 
+// Function to seed the random generator of NTL, which the protocol draws its randomness from, from the random device
+// of the system
+void SeedRandomGenerator();
+
 // Helper method to format a number of bytes in a more readable form
 std::string FormatBytes(uint64 bytes);
 
@@ -0,0 +1,56 @@
+#ifndef OTMPSI_UTILS_ZZCODEC_H_
+#define OTMPSI_UTILS_ZZCODEC_H_
+
+#include <NTL/ZZ.h>
+
+#include <vector>
+
+#include "common.h"
+
+// Class for encoding batches of non-negative numbers into one contiguous buffer and back. Limbs are copied directly
+// between the numbers and the buffer, and decoding reuses the storage the destination numbers already own, so a
+// batch costs no allocation once the destinations have grown to size.
+//
+// In the fixed format every number takes width bytes, little endian and zero padded, exactly as BytesFromZZ writes
+// it, so a fixed batch is the same on the wire as the numbers sent one by one. In the packed format every number is
+// prefixed with its length in two bytes and its leading zero bytes are dropped.
+class ZzCodec {
+public:
+    // Delete the default constructor
+    ZzCodec() = delete;
+
+    // Constructor that takes the width of a number in bytes and the wire format
+    ZzCodec(uint32 width, ZzFormat format);
+
+    // Method to get the largest number of bytes count numbers encode to
+    [[nodiscard]] inline uint64 MaxEncodedSize(uint64 count) const {
+        return count * (format_ == ZzFormat::packed ? packedLengthBytes + width_ : width_);
+    }
+
+    // Method to encode a number at buf, returns the position after it
+    uint8 *EncodeNext(uint8 *buf, const NTL::ZZ &n) const;
+
+    // Method to decode a number at buf into n, returns the position after it
+    const uint8 *DecodeNext(NTL::ZZ &n, const uint8 *buf) const;
+
+    // Method to encode count numbers into buf, returns the number of bytes written
+    uint64 Encode(uint8 *buf, const NTL::ZZ *numbers, uint64 count) const;
+
+    // Method to decode count numbers from buf, returns the number of bytes read
+    uint64 Decode(NTL::ZZ *numbers, const uint8 *buf, uint64 count) const;
+
+    // Method to get the width of a number in bytes
+    [[nodiscard]] inline uint32 width() const { return width_; }
+
+    // Method to get the wire format
+    [[nodiscard]] inline ZzFormat format() const { return format_; }
+
+private:
+    // Number of bytes of the length prefix of a packed number
+    static const uint32 packedLengthBytes = 2;
+
+    uint32 width_;
+    ZzFormat format_;
+};
+
+#endif // OTMPSI_UTILS_ZZCODEC_H_
@@ -0,0 +1,52 @@
+#include "crypto/encryption_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/parallel.h"
+
+// Number of bits of the seeds the threads draw their randomness from
+static const long seedBits = 256;
+
+// Method to fill the pool up to count encryptions on num_threads threads
+void EncryptionPool::Fill(uint64 count, uint32 num_threads) {
+    uint64 first = encryptions_.size();
+    if (count <= first) {
+        return;
+    }
+    encryptions_.resize(count);
+
+    // ParallelFor runs the first range on the calling thread, which reseeds its generator. A seed is drawn for the
+    // caller as well and restored afterwards, so the caller's own stream does not depend on the pool
+    ZZ caller_seed;
+    NTL::RandomBits(caller_seed, seedBits);
+    std::vector<ZZ> seeds(std::max<uint32>(num_threads, 1));
+    for (auto &seed: seeds) {
+        NTL::RandomBits(seed, seedBits);
+    }
+    std::atomic<uint32> next_seed(0);
+    ParallelFor(count - first, num_threads, [&](uint64 begin, uint64 end) {
+        NTL::SetSeed(seeds[next_seed++]);
+        const ZZ zero(0);
+        PaillierContext paillier(public_key_);
+        for (uint64 i = first + begin; i < first + end; ++i) {
+            paillier.EncryptInto(encryptions_[i], zero);
+        }
+    }, 16);
+    NTL::SetSeed(caller_seed);
+}
+
+// Method to take count encryptions out of the pool into dest
+void EncryptionPool::Take(std::vector<ZZ> &dest, uint64 count) {
+    if (count > encryptions_.size()) {
+        throw std::invalid_argument("the encryption pool holds " + std::to_string(encryptions_.size()) +
+                                    " encryptions, " + std::to_string(count) + " were taken");
+    }
+    dest.resize(count);
+    uint64 first = encryptions_.size() - count;
+    for (uint64 i = 0; i < count; ++i) {
+        std::swap(dest[i], encryptions_[first + i]);
+    }
+    encryptions_.resize(first);
+}
@@ -0,0 +1,274 @@
+#include "crypto/key_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// First word of a cache file, "TPKC" read as little endian
+const uint32 keyCacheMagic = 0x434b5054;
+// Version of the layout of a cache file, files of other versions are regenerated
+const uint32 keyCacheVersion = 1;
+
+// Function to append a 32-bit word to buf, little endian
+void PutWord(std::vector<uint8> &buf, uint32 word) {
+    for (uint32 i = 0; i < 4; i++) {
+        buf.push_back(static_cast<uint8>(word >> (8 * i)));
+    }
+}
+
+// Function to append a non-negative number to buf, prefixed with its length in bytes
+void PutNumber(std::vector<uint8> &buf, const NTL::ZZ &n) {
+    uint32 length = NTL::NumBytes(n);
+    PutWord(buf, length);
+    uint64 at = buf.size();
+    buf.resize(at + length);
+    NTL::BytesFromZZ(buf.data() + at, n, length);
+}
+
+// Class for reading words and numbers from a cache file in memory, a read past the end fails and so do all after it
+class CacheReader {
+public:
+    CacheReader(const uint8 *data, uint64 size) : position_(data), end_(data + size) {}
+
+    // Method to read a 32-bit word, returns false if the file ends
+    bool Word(uint32 &word) {
+        if (end_ - position_ < 4) {
+            position_ = end_;
+            failed_ = true;
+            return false;
+        }
+        word = 0;
+        for (uint32 i = 0; i < 4; i++) {
+            word |= static_cast<uint32>(position_[i]) << (8 * i);
+        }
+        position_ += 4;
+        return true;
+    }
+
+    // Method to read a number, returns false if the file ends
+    bool Number(NTL::ZZ &n) {
+        uint32 length;
+        if (!Word(length)) {
+            return false;
+        }
+        if (static_cast<uint64>(end_ - position_) < length) {
+            position_ = end_;
+            failed_ = true;
+            return false;
+        }
+        NTL::ZZFromBytes(n, position_, length);
+        position_ += length;
+        return true;
+    }
+
+    // Method to check that every read succeeded and the whole file was read
+    [[nodiscard]] bool Done() const { return !failed_ && position_ == end_; }
+
+private:
+    const uint8 *position_;
+    const uint8 *end_;
+    bool failed_ = false;
+};
+
+// Class for a file mapped read-only into memory, empty if the file does not exist
+class KeyCacheMapping {
+public:
+    // Constructor that maps the file at path, throws if it exists but cannot be mapped
+    explicit KeyCacheMapping(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                return;
+            }
+            throw std::runtime_error("open " + path + ": " + std::strerror(errno));
+        }
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                // The file is read front to back, let the kernel read ahead
+                madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data_ = static_cast<const uint8 *>(p);
+                size_ = st.st_size;
+            }
+        }
+        int error = errno;
+        close(fd);
+        if (data_ == nullptr && st.st_size > 0) {
+            throw std::runtime_error("mmap " + path + ": " + std::strerror(error));
+        }
+    }
+
+    // Destructor that unmaps the file
+    ~KeyCacheMapping() {
+        if (data_ != nullptr) {
+            munmap(const_cast<uint8 *>(data_), size_);
+        }
+    }
+
+    KeyCacheMapping(const KeyCacheMapping &) = delete;
+    KeyCacheMapping &operator=(const KeyCacheMapping &) = delete;
+
+    [[nodiscard]] const uint8 *data() const { return data_; }
+    [[nodiscard]] uint64 size() const { return size_; }
+
+private:
+    const uint8 *data_ = nullptr;
+    uint64 size_ = 0;
+};
+
+} // namespace
+
+// Function to get the path of the cache file of the keys with the given parameters in directory
+std::string KeyCachePath(const std::string &directory, uint32 seed, long key_length, long threshold_l,
+                         long parties_t) {
+    std::string name = "keys_" + std::to_string(seed) + "_" + std::to_string(key_length) + "_" +
+                       std::to_string(threshold_l) + "_" + std::to_string(parties_t) + ".bin";
+    return (std::filesystem::path(directory) / name).string();
+}
+
+// Function to load keys from a cache file, returns false if there is no file or it holds keys with other parameters
+bool LoadKeys(Keys *keys, const std::string &path, uint32 seed, long key_length, long threshold_l, long parties_t) {
+    KeyCacheMapping file(path);
+    CacheReader reader(file.data(), file.size());
+    uint32 magic, version, file_seed, file_key_length, file_threshold_l, file_parties_t;
+    if (!reader.Word(magic) || !reader.Word(version) || !reader.Word(file_seed) || !reader.Word(file_key_length) ||
+        !reader.Word(file_threshold_l) || !reader.Word(file_parties_t)) {
+        return false;
+    }
+    if (magic != keyCacheMagic || version != keyCacheVersion || file_seed != seed || file_key_length != key_length ||
+        file_threshold_l != threshold_l || file_parties_t != parties_t) {
+        return false;
+    }
+
+    PublicKey &public_key = keys->public_key;
+    ZZ p, q;
+    reader.Number(public_key.n);
+    reader.Number(public_key.theta);
+    reader.Number(public_key.delta);
+    reader.Number(public_key.combine_inverse);
+    reader.Number(p);
+    reader.Number(q);
+    keys->private_keys.resize(parties_t);
+    for (auto &private_key: keys->private_keys) {
+        reader.Number(private_key);
+    }
+
+    auto table = std::make_shared<NthResidueTable>();
+    uint32 exponent_bits = 0, window_bits = 0, windows = 0, powers = 0;
+    if (reader.Word(exponent_bits) && reader.Word(window_bits) && reader.Word(windows) && reader.Word(powers)) {
+        // A corrupt count must not allocate more numbers than the file can hold
+        if (static_cast<uint64>(windows) * powers > file.size() / 4) {
+            return false;
+        }
+        table->exponent_bits = exponent_bits;
+        table->window_bits = window_bits;
+        table->powers.resize(windows);
+        for (auto &window: table->powers) {
+            window.resize(powers);
+            for (auto &power: window) {
+                reader.Number(power);
+            }
+        }
+    }
+    if (!reader.Done() || p * q != public_key.n) {
+        return false;
+    }
+
+    public_key.g = public_key.n + 1;
+    public_key.n_squared = public_key.n * public_key.n;
+    public_key.threshold_l = threshold_l;
+    public_key.crt = make_crt_parameters(p, q);
+    public_key.nth_residues = table;
+    public_key.lagrange = std::make_shared<LagrangeCache>();
+    return true;
+}
+
+// Function to store keys in a cache file, throws if the file cannot be written
+void StoreKeys(const Keys &keys, const std::string &path, uint32 seed, long key_length) {
+    const PublicKey &public_key = keys.public_key;
+    if (public_key.crt == nullptr || public_key.nth_residues == nullptr) {
+        throw std::invalid_argument("only keys with their factorization and table of n-th residues can be cached");
+    }
+    std::vector<uint8> buf;
+    PutWord(buf, keyCacheMagic);
+    PutWord(buf, keyCacheVersion);
+    PutWord(buf, seed);
+    PutWord(buf, key_length);
+    PutWord(buf, public_key.threshold_l);
+    PutWord(buf, keys.private_keys.size());
+    PutNumber(buf, public_key.n);
+    PutNumber(buf, public_key.theta);
+    PutNumber(buf, public_key.delta);
+    PutNumber(buf, public_key.combine_inverse);
+    PutNumber(buf, public_key.crt->p);
+    PutNumber(buf, public_key.crt->q);
+    for (const auto &private_key: keys.private_keys) {
+        PutNumber(buf, private_key);
+    }
+    const auto &table = *public_key.nth_residues;
+    PutWord(buf, table.exponent_bits);
+    PutWord(buf, table.window_bits);
+    PutWord(buf, table.powers.size());
+    PutWord(buf, table.powers.empty() ? 0 : table.powers[0].size());
+    for (const auto &window: table.powers) {
+        for (const auto &power: window) {
+            PutNumber(buf, power);
+        }
+    }
+
+    // Write under a name of this writer, then rename over the cache file in one step. The simulated parties are
+    // threads of one process storing the same keys, so the name counts the writers of the process as well
+    static std::atomic<uint64> writers(0);
+    std::string temporary = path + "." + std::to_string(getpid()) + "." + std::to_string(writers++) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        if (!out) {
+            throw std::runtime_error("failed to write " + temporary);
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        // Another writer may have installed the same keys in the meantime
+        Keys installed;
+        if (!LoadKeys(&installed, path, seed, key_length, public_key.threshold_l,
+                      static_cast<long>(keys.private_keys.size()))) {
+            throw std::runtime_error("rename " + temporary + ": " + error.message());
+        }
+    }
+}
+
+// Function to get the keys derived from seed, from the cache in directory if they are there and generated otherwise
+void CachedKeyGen(Keys *keys, const std::string &directory, uint32 seed, long key_length, long threshold_l,
+                  long parties_t, uint32 num_threads) {
+    std::string path;
+    if (!directory.empty()) {
+        path = KeyCachePath(directory, seed, key_length, threshold_l, parties_t);
+        if (LoadKeys(keys, path, seed, key_length, threshold_l, parties_t)) {
+            return;
+        }
+    }
+
+    *keys = Keys();
+    NTL::SetSeed(NTL::conv<NTL::ZZ>(seed));
+    key_gen(keys, key_length, threshold_l, parties_t, num_threads);
+    if (!path.empty()) {
+        std::filesystem::create_directories(directory);
+        StoreKeys(*keys, path, seed, key_length);
+    }
+}
@@ -0,0 +1,45 @@
+#include "crypto/slot_packing.h"
+
+#include <stdexcept>
+
+// Constructor that takes the bound of the absolute values and the public key they are encrypted under
+SlotPacking::SlotPacking(const ZZ &bound, const PublicKey &public_key) : bound_(bound) {
+    // A slot holds a value plus bound, which is below 2 * bound + 1, and a guard bit
+    slot_bits_ = NTL::NumBits(2 * bound_ + 1) + 1;
+    // All slots together stay below 2^(NumBits(n) - 2) <= n / 2
+    slots_ = (NTL::NumBits(public_key.n) - 2) / slot_bits_;
+    if (slots_ < 1) {
+        throw std::invalid_argument("the values are too large to be packed");
+    }
+    NTL::power2(shift_, slot_bits_);
+}
+
+// Method to pack the ciphertexts of count values into dest
+void SlotPacking::PackInto(ZZ &dest, const ZZ *ciphertexts, long count, PaillierContext &paillier) const {
+    if (count < 1 || count > slots_) {
+        throw std::invalid_argument("cannot pack " + std::to_string(count) + " values into " +
+                                    std::to_string(slots_) + " slots");
+    }
+    // The first value ends up in the lowest slot
+    dest = ciphertexts[count - 1];
+    for (long i = count - 2; i >= 0; --i) {
+        paillier.MultiplyInto(dest, dest, shift_);
+        paillier.AddInto(dest, dest, ciphertexts[i]);
+    }
+}
+
+// Method to split the decrypted plaintext of count packed values into values
+void SlotPacking::Unpack(ZZ *values, const ZZ &plaintext, long count) const {
+    // Offset every slot by bound, the slots are then non-negative and split without borrows
+    ZZ offset, packed;
+    for (long i = 0; i < count; ++i) {
+        NTL::LeftShift(offset, offset, slot_bits_);
+        NTL::add(offset, offset, bound_);
+    }
+    NTL::add(packed, plaintext, offset);
+    for (long i = 0; i < count; ++i) {
+        NTL::trunc(values[i], packed, slot_bits_);
+        NTL::sub(values[i], values[i], bound_);
+        NTL::RightShift(packed, packed, slot_bits_);
+    }
+}
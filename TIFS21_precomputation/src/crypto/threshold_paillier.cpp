@@ -5,29 +5,146 @@
 #include "crypto/threshold_paillier.h"
 
 
-// TODO: Consider changing ZZs to references
 // TODO: NTL:ZZ to ZZ
 // TODO: Generalize towards an arbitrary number of t and l
 // TODO: Fix comments (shorten?)
 // TODO: Consider rewriting ZZ to ZZ_p (p does not have to be prime)
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <stdexcept>
 
-static void GenSafePrimePair(NTL::ZZ& p, NTL::ZZ& q, NTL::ZZ& pp, NTL::ZZ& qq, long keyLength){
-    /* Coprime generation function. Generates a random coprime number of n.
+#include "utils/parallel.h"
+
+// Number of bits of the exponents of the randomness, twice the security level of 2048-bit keys rounded up
+static const long nthResidueExponentBits = 256;
+// Number of bits of the windows of the fixed-base exponentiation, the table holds 2^8 powers per window
+static const long nthResidueWindowBits = 8;
+
+// Bound of the odd primes the candidates of the safe prime search are sieved with
+static const long safePrimeSieveBound = 1L << 15;
+// Number of candidates of one window of the safe prime search, for 1024 bits about every other window holds a
+// Germain prime
+static const long safePrimeWindowSize = 1L << 16;
+// Number of Miller-Rabin rounds for pp and for 2 * pp + 1
+static const long safePrimeRounds = 8;
+
+static const std::vector<long>& SmallPrimes() {
+    /* The odd primes below safePrimeSieveBound, by the sieve of Eratosthenes.
+     */
+    static const std::vector<long> primes = [] {
+        std::vector<long> primes;
+        std::vector<bool> composite(safePrimeSieveBound, false);
+        for (long i = 3; i < safePrimeSieveBound; i += 2) {
+            if (!composite[i]) {
+                primes.push_back(i);
+                for (long j = i * i; j < safePrimeSieveBound; j += 2 * i) {
+                    composite[j] = true;
+                }
+            }
+        }
+        return primes;
+    }();
+    return primes;
+}
+
+static bool IsGermainPrime(const ZZ& pp, ZZ& p, ZZ& witness) {
+    /* Primality test of pp and p = 2 * pp + 1 by Miller-Rabin with the bases 2, 3, 5, ...
+     *
+     * The bases are fixed rather than random, so the test does not draw from the random generator and the search
+     * gives the same primes on any number of threads. The candidates are random, not chosen by an adversary, for
+     * which fixed bases are as good.
+     */
+    p = 2 * pp + 1;
+    for (long round = 0; round < safePrimeRounds; ++round) {
+        witness = round == 0 ? 2 : SmallPrimes()[round - 1];
+        if (NTL::MillerWitness(pp, witness) || NTL::MillerWitness(p, witness)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SieveGermainPrime(ZZ& pp, long bits, long num_threads) {
+    /* Germain prime generation function. Searches the odd numbers from a random start of the given bit length.
+     *
+     * The candidates pp = start + 2 * i of a window are sieved: i is struck out if a small prime divides pp or
+     * 2 * pp + 1. The remaining candidates are split among the threads, and the first Germain prime of the window is
+     * taken, so the result depends on the random start only, not on the number of threads.
+     *
+     * Parameters
+     * ==========
+     * NTL::ZZ pp: the Germain prime found, i.e. pp and 2 * pp + 1 are primes.
+     * long bits: the bit length of pp.
+     * long num_threads: the number of threads that test candidates.
+     */
+    const std::vector<long>& primes = SmallPrimes();
+    ZZ start;
+    NTL::RandomBits(start, bits);
+    NTL::SetBit(start, bits - 1);
+    NTL::SetBit(start, 0);
+
+    std::vector<char> composite(safePrimeWindowSize);
+    std::vector<long> candidates;
+    while (true) {
+        std::fill(composite.begin(), composite.end(), 0);
+        for (long prime : primes) {
+            long r = NTL::rem(start, prime);
+            long half = (prime + 1) / 2; // 2^-1 mod prime
+            // prime divides pp for i = -r / 2 and 2 * pp + 1 for i = -(2 * r + 1) / 4
+            long first_pp = (prime - r) % prime * half % prime;
+            long first_p = (prime - (2 * r + 1) % prime) % prime * half % prime * half % prime;
+            for (long i = first_pp; i < safePrimeWindowSize; i += prime) {
+                composite[i] = 1;
+            }
+            for (long i = first_p; i < safePrimeWindowSize; i += prime) {
+                composite[i] = 1;
+            }
+        }
+        candidates.clear();
+        for (long i = 0; i < safePrimeWindowSize; ++i) {
+            if (!composite[i]) {
+                candidates.push_back(i);
+            }
+        }
+
+        // Every thread tests its candidates in order and stops at a Germain prime or at one found before its own
+        std::atomic<uint64> found(candidates.size());
+        ParallelFor(candidates.size(), num_threads, [&](uint64 begin, uint64 end) {
+            ZZ candidate, p, witness;
+            for (uint64 k = begin; k < end && k < found.load(); ++k) {
+                candidate = start + 2 * candidates[k];
+                if (IsGermainPrime(candidate, p, witness)) {
+                    uint64 current = found.load();
+                    while (k < current && !found.compare_exchange_weak(current, k)) {}
+                    return;
+                }
+            }
+        }, 1);
+        if (found.load() < candidates.size()) {
+            pp = start + 2 * candidates[found.load()];
+            return;
+        }
+        start += 2 * safePrimeWindowSize;
+    }
+}
+
+static void GenSafePrimePair(NTL::ZZ& p, NTL::ZZ& q, NTL::ZZ& pp, NTL::ZZ& qq, long keyLength, long num_threads){
+    /* Safe prime generation function. Generates two distinct safe primes.
      *
      * Parameters
      * ==========
      * NTL::ZZ p, q, pp, qq: p and q are safe primes in the same bit length, i.e. p = 2 * pp + 1 and q = 2 * qq + 1,
      *                       where pp and qq are primes.
      * long keyLength: the length of the key.
+     * long num_threads: the number of threads of the search.
      */
     while (true) {
-        long err = 80;
-        pp = NTL::GenGermainPrime_ZZ(keyLength/2, err);
-        qq = NTL::GenGermainPrime_ZZ(keyLength/2, err);
+        SieveGermainPrime(pp, keyLength/2, num_threads);
+        SieveGermainPrime(qq, keyLength/2, num_threads);
         while (pp == qq) {
-            qq = NTL::GenGermainPrime_ZZ(keyLength/2, err);
+            SieveGermainPrime(qq, keyLength/2, num_threads);
         }
         p = 2 * pp + 1;
         q = 2 * qq + 1;
@@ -60,11 +177,172 @@ ZZ Gen_Coprime(const NTL::ZZ& n) {
 
 static ZZ L_function(const ZZ& x, const ZZ& n) { return (x - 1) / n; }
 
+static long Window(const ZZ& exponent, long k, long window_bits) {
+    // Window k of window_bits bits of the exponent, counting from the least significant one
+    long window = 0;
+    for (long b = window_bits - 1; b >= 0; --b) {
+        window = (window << 1) | NTL::bit(exponent, k * window_bits + b);
+    }
+    return window;
+}
+
+static ZZ MultiPowerMod(const std::vector<ZZ>& bases, const std::vector<ZZ>& exponents, const ZZ& modulus) {
+    /* Simultaneous exponentiation by Straus' method: the product of the powers shares one chain of squarings, and
+     * every base takes one multiplication per window of its exponent. The powers with negative exponents are
+     * multiplied into a second product, which is inverted once at the end.
+     *
+     * Parameters
+     * ==========
+     * std::vector<NTL::ZZ> bases : units modulo the modulus, reduced.
+     * std::vector<NTL::ZZ> exponents : the exponents, may be negative.
+     *
+     * Returns
+     * =======
+     * NTL::ZZ result : the product of bases[i]^exponents[i] mod modulus.
+     */
+    long bits = 0;
+    bool negative = false;
+    std::vector<ZZ> magnitudes(exponents.size());
+    for (size_t i = 0; i < exponents.size(); ++i) {
+        magnitudes[i] = NTL::abs(exponents[i]);
+        bits = std::max(bits, NTL::NumBits(magnitudes[i]));
+        negative = negative || exponents[i] < 0;
+    }
+    // Tables of powers only pay off for long exponents, the ones of Lagrange coefficients are a few bits long
+    const long window_bits = bits > 64 ? 4 : 1;
+
+    // powers[i][j] = bases[i]^j
+    std::vector<std::vector<ZZ>> powers(bases.size(), std::vector<ZZ>(1L << window_bits));
+    for (size_t i = 0; i < bases.size(); ++i) {
+        powers[i][0] = 1;
+        for (size_t j = 1; j < powers[i].size(); ++j) {
+            powers[i][j] = NTL::MulMod(powers[i][j - 1], bases[i], modulus);
+        }
+    }
+
+    // products[0] collects the powers with positive exponents, products[1] the ones with negative exponents
+    ZZ products[2] = {ZZ(1), ZZ(1)};
+    for (long k = (bits + window_bits - 1) / window_bits - 1; k >= 0; --k) {
+        for (long s = 0; s < window_bits; ++s) {
+            NTL::SqrMod(products[0], products[0], modulus);
+            if (negative) {
+                NTL::SqrMod(products[1], products[1], modulus);
+            }
+        }
+        for (size_t i = 0; i < bases.size(); ++i) {
+            long window = Window(magnitudes[i], k, window_bits);
+            if (window != 0) {
+                ZZ& product = products[exponents[i] < 0 ? 1 : 0];
+                NTL::MulMod(product, product, powers[i][window], modulus);
+            }
+        }
+    }
+    if (negative) {
+        return NTL::MulMod(products[0], NTL::InvMod(products[1], modulus), modulus);
+    }
+    return products[0];
+}
+
+
+static const ZZ& ReducedExponent(const ZZ& exponent, const ZZ& order, ZZ& scratch) {
+    // Exponents longer than the order of the group are reduced modulo it into scratch, shorter ones are kept even if
+    // negative, as the Lagrange coefficients would grow to the size of the order
+    if (NTL::NumBits(exponent) >= NTL::NumBits(order)) {
+        NTL::rem(scratch, exponent, order);
+        return scratch;
+    }
+    return exponent;
+}
+
+static void CrtCombine(ZZ& dest, const ZZ& result_p, const ZZ& result_q, const CrtParameters& crt, ZZ& scratch) {
+    // Garner's recombination: dest = result_q + q^2 * ((result_p - result_q) * q^-2 mod p^2)
+    NTL::sub(scratch, result_p, result_q);
+    NTL::rem(scratch, scratch, crt.p_squared);
+    NTL::MulMod(scratch, scratch, crt.q_squared_inverse, crt.p_squared);
+    NTL::mul(scratch, scratch, crt.q_squared);
+    NTL::add(dest, result_q, scratch);
+}
+
+static ZZ MultiPowerModNSquared(const std::vector<ZZ>& bases, const std::vector<ZZ>& exponents,
+                                const PublicKey& public_key) {
+    /* Product of powers modulo n^2, by the Chinese remainder theorem if the factorization of n is known.
+     *
+     * Parameters
+     * ==========
+     * std::vector<NTL::ZZ> bases : units modulo n^2, e.g. partial decryptions.
+     * std::vector<NTL::ZZ> exponents : the exponents, may be negative.
+     *
+     * Returns
+     * =======
+     * NTL::ZZ result : the product of bases[i]^exponents[i] mod n^2.
+     */
+    std::vector<ZZ> reduced_bases(bases.size()), reduced_exponents(exponents.size());
+    if (!public_key.crt) {
+        for (size_t i = 0; i < bases.size(); ++i) {
+            reduced_bases[i] = bases[i] % public_key.n_squared;
+        }
+        return MultiPowerMod(reduced_bases, exponents, public_key.n_squared);
+    }
+    const CrtParameters& crt = *public_key.crt;
+
+    ZZ results[2], scratch;
+    const ZZ* moduli[2] = {&crt.p_squared, &crt.q_squared};
+    const ZZ* orders[2] = {&crt.phi_p_squared, &crt.phi_q_squared};
+    for (int r = 0; r < 2; ++r) {
+        for (size_t i = 0; i < bases.size(); ++i) {
+            NTL::rem(reduced_bases[i], bases[i], *moduli[r]);
+            reduced_exponents[i] = ReducedExponent(exponents[i], *orders[r], scratch);
+        }
+        results[r] = MultiPowerMod(reduced_bases, reduced_exponents, *moduli[r]);
+    }
+    CrtCombine(results[0], results[0], results[1], crt, scratch);
+    return results[0];
+}
 
-void key_gen(Keys* keys, const long key_length, long threshold_l, long parties_t) {
+static std::shared_ptr<NthResidueTable> BuildNthResidueTable(const PublicKey& public_key) {
+    /* Table for fixed-base exponentiation of a random n-th residue h.
+     *
+     * Returns
+     * =======
+     * NthResidueTable table : the powers of h for exponents of nthResidueExponentBits bits.
+     */
+    auto table = std::make_shared<NthResidueTable>();
+    table->exponent_bits = nthResidueExponentBits;
+    table->window_bits = nthResidueWindowBits;
+    long windows = (nthResidueExponentBits + nthResidueWindowBits - 1) / nthResidueWindowBits;
+    table->powers.resize(windows);
+
+    // base is h^(2^(k * window_bits)) for window k
+    ZZ base;
+    PaillierContext(public_key).UniformNthResidueInto(base);
+    for (long k = 0; k < windows; ++k) {
+        std::vector<ZZ>& powers = table->powers[k];
+        powers.resize(1L << nthResidueWindowBits);
+        powers[0] = 1;
+        for (size_t j = 1; j < powers.size(); ++j) {
+            powers[j] = NTL::MulMod(powers[j - 1], base, public_key.n_squared);
+        }
+        base = NTL::MulMod(powers.back(), base, public_key.n_squared);
+    }
+    return table;
+}
+
+std::shared_ptr<const CrtParameters> make_crt_parameters(const ZZ& p, const ZZ& q) {
+    auto crt = std::make_shared<CrtParameters>();
+    crt->p = p;
+    crt->q = q;
+    crt->p_squared = p * p;
+    crt->q_squared = q * q;
+    crt->phi_p_squared = p * (p - 1);
+    crt->phi_q_squared = q * (q - 1);
+    crt->q_squared_inverse = NTL::InvMod(crt->q_squared % crt->p_squared, crt->p_squared);
+    return crt;
+}
+
+void key_gen(Keys* keys, const long key_length, long threshold_l, long parties_t, long num_threads) {
     ZZ p, q, pp, qq;
 
-    GenSafePrimePair(p, q, pp, qq, key_length);
+    GenSafePrimePair(p, q, pp, qq, key_length, num_threads);
 
     // General key generation
     ZZ n = p * q;
@@ -72,7 +350,11 @@ void key_gen(Keys* keys, const long key_length, long threshold_l, long parties_t
     ZZ g = n + 1;
     ZZ beta = Gen_Coprime(n);
     ZZ theta = NTL::MulMod(m, beta, n);
-    ZZ delta(tgamma(parties_t + 1));
+    // delta = t!
+    ZZ delta(1);
+    for (long i = 2; i <= parties_t; ++i) {
+        delta *= i;
+    }
 
     keys->public_key = PublicKey {
         g,
@@ -83,6 +365,8 @@ void key_gen(Keys* keys, const long key_length, long threshold_l, long parties_t
         threshold_l
     };
 
+    keys->public_key.crt = make_crt_parameters(p, q);
+
     // Secret key generation
     std::vector<ZZ> coefficients;
     coefficients.reserve(threshold_l);
@@ -102,51 +386,202 @@ void key_gen(Keys* keys, const long key_length, long threshold_l, long parties_t
 
         keys->private_keys.push_back(key % (n * m));
     }
+
+    keys->public_key.nth_residues = BuildNthResidueTable(keys->public_key);
+    keys->public_key.combine_inverse = NTL::InvMod(4 * delta * delta * theta % n, n);
+    keys->public_key.lagrange = std::make_shared<LagrangeCache>();
+}
+
+const std::vector<ZZ>& LagrangeCache::Coefficients(const std::vector<long>& indices, const ZZ& delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = coefficients_.find(indices);
+    if (it != coefficients_.end()) {
+        return it->second;
+    }
+
+    // delta * lambda_i = delta * prod_{i' != i} i' / (i' - i), an integer as delta = t!
+    std::vector<ZZ> coefficients;
+    coefficients.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        ZZ numerator = delta, denominator(1);
+        for (size_t i_prime = 0; i_prime < indices.size(); ++i_prime) {
+            if (indices[i] != indices[i_prime]) {
+                numerator *= indices[i_prime];
+                denominator *= indices[i_prime] - indices[i];
+            }
+        }
+        ZZ &coefficient = coefficients.emplace_back(), remainder;
+        NTL::DivRem(coefficient, remainder, numerator, denominator);
+        if (remainder != 0) {
+            throw std::invalid_argument("delta times a Lagrange coefficient is not an integer, the indices "
+                                        "must lie in [1, t]");
+        }
+    }
+    return coefficients_.emplace(indices, std::move(coefficients)).first->second;
+}
+
+void PaillierContext::PowerModInto(ZZ& dest, const ZZ& base, const ZZ& exponent) {
+    /* Exponentiation modulo n^2, by the Chinese remainder theorem if the factorization of n is known. Half-size
+     * moduli, and exponents reduced to the size of n, make a partial decryption about three times faster.
+     *
+     * Parameters
+     * ==========
+     * NTL::ZZ base : a unit modulo n^2, e.g. a ciphertext.
+     * NTL::ZZ exponent : the exponent, may be negative.
+     */
+    if (!public_key_.crt) {
+        NTL::rem(base_p_, base, public_key_.n_squared);
+        NTL::PowerMod(dest, base_p_, exponent, public_key_.n_squared);
+        return;
+    }
+    const CrtParameters& crt = *public_key_.crt;
+
+    // The base is a unit, so the exponents can be reduced modulo the orders of the groups
+    NTL::rem(base_p_, base, crt.p_squared);
+    NTL::rem(base_q_, base, crt.q_squared);
+    NTL::PowerMod(base_p_, base_p_, ReducedExponent(exponent, crt.phi_p_squared, exponent_p_), crt.p_squared);
+    NTL::PowerMod(base_q_, base_q_, ReducedExponent(exponent, crt.phi_q_squared, exponent_q_), crt.q_squared);
+    CrtCombine(dest, base_p_, base_q_, crt, difference_);
+}
+
+void PaillierContext::UniformNthResidueInto(ZZ& dest) {
+    /* Random n-th residue modulo n^2, distributed as r^n for a random unit r modulo n.
+     *
+     * Modulo p^2, x^p only depends on x mod p, so r^n = (r^q mod p)^p mod p^2, and r^q mod p is a random unit modulo
+     * p as q is coprime to p - 1. Raising random units modulo p and q to the powers p and q and recombining thus
+     * takes two exponentiations with half-size moduli and exponents of a quarter of the size of n^2.
+     */
+    if (!public_key_.crt) {
+        NTL::PowerMod(dest, Gen_Coprime(public_key_.n), public_key_.n, public_key_.n_squared);
+        return;
+    }
+    const CrtParameters& crt = *public_key_.crt;
+    NTL::sub(difference_, crt.p, 1);
+    NTL::RandomBnd(base_p_, difference_);
+    NTL::add(base_p_, base_p_, 1);
+    NTL::PowerMod(base_p_, base_p_, crt.p, crt.p_squared);
+    NTL::sub(difference_, crt.q, 1);
+    NTL::RandomBnd(base_q_, difference_);
+    NTL::add(base_q_, base_q_, 1);
+    NTL::PowerMod(base_q_, base_q_, crt.q, crt.q_squared);
+    CrtCombine(dest, base_p_, base_q_, crt, difference_);
+}
+
+void PaillierContext::RandomNthResidueInto(ZZ& dest) {
+    /* Random n-th residue modulo n^2, the randomness of an encryption. Drawn as h^a for a short random exponent a by
+     * fixed-base exponentiation if the public key has a table of powers of h, which takes one multiplication per
+     * window of a instead of an exponentiation.
+     */
+    if (!public_key_.nth_residues) {
+        UniformNthResidueInto(dest);
+        return;
+    }
+    const NthResidueTable& table = *public_key_.nth_residues;
+
+    NTL::RandomBits(residue_exponent_, table.exponent_bits);
+    NTL::set(dest);
+    for (long k = 0; k < static_cast<long>(table.powers.size()); ++k) {
+        long window = Window(residue_exponent_, k, table.window_bits);
+        if (window != 0) {
+            NTL::MulMod(dest, dest, table.powers[k][window], public_key_.n_squared);
+        }
+    }
 }
 
-ZZ encrypt(ZZ message, const PublicKey& public_key) {
+void PaillierContext::EncryptInto(ZZ& dest, const ZZ& message) {
     /* Paillier encryption function. Takes in a message in F(modulus), and returns a message in F(modulus**2).
      *
      * Parameters
      * ==========
      * NTL::ZZ message : the message to be encrypted.
-     *
-     * Returns
-     * =======
-     * NTL:ZZ ciphertext : the encyrpted message.
      */
     // Encode numbers so that positive numbers map to [0, n/2] and negative numbers to [n/2, n]
-    ZZ encoded_message;
-    if (message > 0) {
-        encoded_message = message;
-    } else {
-        encoded_message = public_key.n + message;
+    NTL::rem(message_, message, public_key_.n);
+
+    // g = n + 1, so g^m = 1 + m * n mod n^2 and only the randomness needs an exponentiation
+    NTL::mul(message_, message_, public_key_.n);
+    NTL::add(message_, message_, 1);
+    RandomNthResidueInto(residue_);
+    NTL::MulMod(dest, message_, residue_, public_key_.n_squared);
+}
+
+void PaillierContext::AddInto(ZZ& dest, const ZZ& a, const ZZ& b) const {
+    NTL::MulMod(dest, a, b, public_key_.n_squared);
+}
+
+void PaillierContext::SubtractInto(ZZ& dest, const ZZ& a, const ZZ& b) {
+    NTL::InvMod(inverse_, b, public_key_.n_squared);
+    NTL::MulMod(dest, a, inverse_, public_key_.n_squared);
+}
+
+void PaillierContext::NegateBatchInto(ZZ* dest, const ZZ* a, long count) {
+    /* Batch negation function, by Montgomery's simultaneous inversion. The negation of a ciphertext is its inverse
+     * modulo n^2. The products a[0] * ... * a[i] are inverted once and the inverse of every a[i] is recovered from
+     * the inverse of the product, three multiplications per ciphertext instead of an inversion each.
+     *
+     * Parameters
+     * ==========
+     * NTL::ZZ* dest : the negated ciphertexts, may be a.
+     * NTL::ZZ* a : the ciphertexts to be negated.
+     * long count : the number of ciphertexts.
+     */
+    if (count <= 0) {
+        return;
     }
-    NTL::ZZ random = Gen_Coprime(public_key.n);
+    const ZZ& modulus = public_key_.n_squared;
+    if (static_cast<long>(products_.size()) < count) {
+        products_.resize(count);
+    }
+    products_[0] = a[0];
+    for (long i = 1; i < count; ++i) {
+        NTL::MulMod(products_[i], products_[i - 1], a[i], modulus);
+    }
+    NTL::InvMod(inverse_, products_[count - 1], modulus);
+    for (long i = count - 1; i > 0; --i) {
+        // inverse_ = (a[0] * ... * a[i])^-1, so a[i]^-1 = inverse_ * a[0] * ... * a[i - 1]
+        NTL::MulMod(difference_, inverse_, a[i], modulus);
+        NTL::MulMod(dest[i], inverse_, products_[i - 1], modulus);
+        NTL::swap(inverse_, difference_);
+    }
+    dest[0] = inverse_;
+}
+
+void PaillierContext::MultiplyInto(ZZ& dest, const ZZ& a, const ZZ& scalar) {
+    PowerModInto(dest, a, scalar);
+}
 
-    // TODO: Use MulMod
-    NTL::ZZ ciphertext = NTL::PowerMod(public_key.g, encoded_message, public_key.n_squared) *
-            NTL::PowerMod(random, public_key.n, public_key.n_squared);
-    return ciphertext % (public_key.n_squared);
+void PaillierContext::RerandomizeInto(ZZ& dest, const ZZ& a) {
+    // Homomorphically add a random encryption of zero, which is just an n-th residue, to the ciphertext
+    RandomNthResidueInto(residue_);
+    NTL::MulMod(dest, a, residue_, public_key_.n_squared);
 }
 
-ZZ partial_decrypt(ZZ& ciphertext, const PublicKey& public_key, ZZ& secret_key) {
+void PaillierContext::PartialDecryptInto(ZZ& dest, const ZZ& ciphertext, const ZZ& secret_key) {
     /* Paillier partial decryption function. Takes in a ciphertext in F(modulus**2), and returns a partial decryption in the same space.
      *
       * Parameters
      * ==========
      * NTL::ZZ cipertext : the encryption of the original message.
      * NTL::ZZ fi : the Pi's share of secret key, i.e., beta * m.
-     *
-     * Returns
-     * =======
-     * NTL::ZZ partial_decryption : The partial decryption of the original message.
      */
-    ZZ partial_decryption = NTL::PowerMod(ciphertext, 2 * public_key.delta * secret_key, public_key.n_squared);
+    NTL::mul(exponent_, public_key_.delta, secret_key);
+    NTL::mul(exponent_, exponent_, 2);
+    PowerModInto(dest, ciphertext, exponent_);
+}
+
+ZZ encrypt(const ZZ& message, const PublicKey& public_key) {
+    ZZ ciphertext;
+    PaillierContext(public_key).EncryptInto(ciphertext, message);
+    return ciphertext;
+}
+
+ZZ partial_decrypt(const ZZ& ciphertext, const PublicKey& public_key, const ZZ& secret_key) {
+    ZZ partial_decryption;
+    PaillierContext(public_key).PartialDecryptInto(partial_decryption, ciphertext, secret_key);
     return partial_decryption;
 }
 
-ZZ combine_partial_decrypt(std::vector<std::pair<long, ZZ>> secret_shares, const PublicKey& public_key) {
+ZZ combine_partial_decrypt(const std::vector<std::pair<long, ZZ>>& secret_shares, const PublicKey& public_key) {
     /* Combine the partial decryptions to obtain the decryption of the original ciphertext.
      *
      * Parameters
@@ -157,32 +592,23 @@ ZZ combine_partial_decrypt(std::vector<std::pair<long, ZZ>> secret_shares, const
      * =======
      * NTL::ZZ M: the decryption of the original message.
      */
-    std::vector<ZZ> lambdas;
     // TODO: Correct mistake here in the paper: it says threshold l out of total l, but we should have l+1 out of t
+    std::vector<long> indices;
+    std::vector<ZZ> shares;
     for (int i = 0; i < (public_key.threshold_l + 1); ++i) {
-        ZZ lambda = public_key.delta;
-
-        for (int i_prime = 0; i_prime < (public_key.threshold_l + 1); ++i_prime) {
-            if (i != i_prime) {
-                if (secret_shares.at(i).first - secret_shares.at(i_prime).first != 0) {
-                    lambda *= secret_shares.at(i_prime).first;
-                    lambda /= secret_shares.at(i_prime).first - secret_shares.at(i).first;
-                }
-            }
-        }
-
-        lambdas.push_back(lambda);
+        indices.push_back(secret_shares.at(i).first);
+        shares.push_back(secret_shares.at(i).second);
     }
+    const std::vector<ZZ>& lambdas = public_key.lagrange->Coefficients(indices, public_key.delta);
 
-    ZZ product(1);
-    for (int i = 0; i < (public_key.threshold_l + 1); ++i) {
-        product = MulMod(product,
-                         PowerMod(secret_shares.at(i).second, 2 * lambdas.at(i), public_key.n_squared),
-                         public_key.n_squared);
+    // The product of the shares raised to 2 * lambda_i in one multi-exponentiation
+    std::vector<ZZ> exponents;
+    for (const ZZ& lambda : lambdas) {
+        exponents.push_back(2 * lambda);
     }
+    ZZ product = MultiPowerModNSquared(shares, exponents, public_key);
 
-    ZZ Inv_temp = NTL::InvMod(4 * public_key.delta * public_key.delta * public_key.theta % public_key.n, public_key.n);
-    ZZ m = NTL::MulMod(L_function(product, public_key.n), Inv_temp, public_key.n);
+    ZZ m = NTL::MulMod(L_function(product, public_key.n), public_key.combine_inverse, public_key.n);
 
     if (m > (public_key.n / 2)) {
         m -= public_key.n;
@@ -192,18 +618,21 @@ ZZ combine_partial_decrypt(std::vector<std::pair<long, ZZ>> secret_shares, const
 //    return ZZ(0);
 }
 
-ZZ add_homomorphically(ZZ c1, ZZ c2, PublicKey& public_key) {
+ZZ add_homomorphically(const ZZ& c1, const ZZ& c2, const PublicKey& public_key) {
     return NTL::MulMod(c1, c2, public_key.n_squared);
 }
 
-ZZ subtract_homomorphically(ZZ c1, ZZ c2, PublicKey& public_key) {
+ZZ subtract_homomorphically(const ZZ& c1, const ZZ& c2, const PublicKey& public_key) {
     return add_homomorphically(c1, NTL::InvMod(c2, public_key.n_squared), public_key);
 }
-ZZ multiply_homomorphically(ZZ ciphertext, ZZ scalar, PublicKey& public_key) {
-    return NTL::PowerMod(ciphertext, scalar, public_key.n_squared);
+ZZ multiply_homomorphically(const ZZ& ciphertext, const ZZ& scalar, const PublicKey& public_key) {
+    ZZ product;
+    PaillierContext(public_key).MultiplyInto(product, ciphertext, scalar);
+    return product;
 }
 
-ZZ rerandomize(ZZ ciphertext, PublicKey& public_key) {
-    // Homomorphically add a random encryption of zero to the ciphertext
-    return add_homomorphically(ciphertext, encrypt(ZZ(0), public_key), public_key);
+ZZ rerandomize(const ZZ& ciphertext, const PublicKey& public_key) {
+    ZZ rerandomized;
+    PaillierContext(public_key).RerandomizeInto(rerandomized, ciphertext);
+    return rerandomized;
 }
@@ -14,8 +14,8 @@ int main(int argc, char *argv[]) {
     NewConfigFromJsonFile(config, argv[1]);
 
     std::vector<ElementType> set;
-    set.reserve(config.element_set_size);
     generate_set(set, config);
+    SeedRandomGenerator();
 
     Participant participant(config.options, set);
 
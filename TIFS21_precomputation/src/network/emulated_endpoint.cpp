@@ -0,0 +1,128 @@
+#include "network/emulated_endpoint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Constructor that takes the wrapped endpoint, the remote name and the link parameters
+EmulatedLink::EmulatedLink(Endpoint *inner, std::string remote_name, const LinkEmulation &emulation,
+                           uint64 buffer_bytes, uint64 seed)
+        : inner_(inner), remote_name_(std::move(remote_name)), emulation_(emulation), buffer_bytes_(buffer_bytes),
+          rng_(seed), wire_free_at_(Clock::now()), last_deliver_at_(Clock::now()) {
+    sender_ = std::thread(&EmulatedLink::SendLoop, this);
+}
+
+// Destructor that drains the queue and joins the sender thread
+EmulatedLink::~EmulatedLink() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    sender_.join();
+}
+
+// Method to queue a message, takes ownership of buf and blocks while the send buffer is full
+void EmulatedLink::Send(void *buf, uint32 len) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [&] { return queue_.empty() || queued_bytes_ + len <= buffer_bytes_; });
+
+    // The message occupies the wire for len / bandwidth after the previous one has gone out
+    auto now = Clock::now();
+    wire_free_at_ = std::max(wire_free_at_, now);
+    if (emulation_.bandwidth_mbps > 0) {
+        wire_free_at_ += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::micro>(len * 8 / emulation_.bandwidth_mbps));
+    }
+
+    // Then it travels for the latency, jittered, but never overtakes the previous message
+    double latency_ms = emulation_.latency_ms;
+    if (emulation_.jitter_ms > 0) {
+        latency_ms += std::uniform_real_distribution<double>(-emulation_.jitter_ms, emulation_.jitter_ms)(rng_);
+    }
+    auto deliver_at = wire_free_at_ + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(std::max(latency_ms, 0.0)));
+    deliver_at = std::max(deliver_at, last_deliver_at_);
+    last_deliver_at_ = deliver_at;
+
+    queue_.push_back({buf, len, deliver_at});
+    queued_bytes_ += len;
+    cv_.notify_all();
+}
+
+// Loop of the sender thread
+void EmulatedLink::SendLoop() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+        cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        auto message = queue_.front();
+        lock.unlock();
+
+        std::this_thread::sleep_until(message.deliver_at);
+        inner_->Write(remote_name_, message.data, message.len);
+        free(message.data);
+
+        lock.lock();
+        queue_.pop_front();
+        queued_bytes_ -= message.len;
+        cv_.notify_all();
+    }
+}
+
+// Method to get the link to a remote endpoint, creating it on first use
+EmulatedLink &EmulatedEndpoint::link(const std::string &remote_name) {
+    std::lock_guard<std::mutex> lock(links_mtx_);
+    auto it = links_.find(remote_name);
+    if (it == links_.end()) {
+        auto override_it = emulation_.links.find(remote_name);
+        const auto &parameters = override_it == emulation_.links.end() ? emulation_.link : override_it->second;
+        auto seed = emulation_.seed ^ std::hash<std::string>()(local_name_ + "/" + remote_name);
+        it = links_.emplace(remote_name, std::make_unique<EmulatedLink>(inner_.get(), remote_name, parameters,
+                                                                        emulation_.buffer_bytes, seed)).first;
+    }
+    return *it->second;
+}
+
+// Method to stop the endpoint, once all queued messages have been delivered
+void EmulatedEndpoint::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(links_mtx_);
+        links_.clear();
+    }
+    inner_->Stop();
+}
+
+// Method to close a connection with a remote endpoint, once all queued messages have been delivered
+void EmulatedEndpoint::CloseChannel(const std::string &remote_name) {
+    {
+        std::lock_guard<std::mutex> lock(links_mtx_);
+        links_.erase(remote_name);
+    }
+    inner_->CloseChannel(remote_name);
+}
+
+// Method to write data to a remote endpoint
+void EmulatedEndpoint::Write(const std::string &remote_name, const void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    void *copy = malloc(len);
+    std::memcpy(copy, buf, len);
+    link(remote_name).Send(copy, len);
+    stats_.RecordWrite(remote_name, len, 0, start);
+}
+
+// Method to asynchronously write data to a remote endpoint, the buffer is freed once delivered
+void EmulatedEndpoint::AsyncWrite(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    link(remote_name).Send(buf, len);
+    stats_.RecordWrite(remote_name, len, 0, start);
+}
+
+// Method to read data from a remote endpoint
+void EmulatedEndpoint::Read(const std::string &remote_name, void *buf, uint32 len) {
+    auto start = TrafficStats::Clock::now();
+    inner_->Read(remote_name, buf, len);
+    stats_.RecordRead(remote_name, len, 0, start);
+}
@@ -1,8 +1,13 @@
 #include "protocol/participant.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
 #include <thread>
 
+#include "crypto/key_cache.h"
+
 const std::string serverName = "server";
 const std::string rightNeighborName = "right";
 const std::string leftNeighborName = "left";
@@ -28,14 +33,21 @@ void Participant::InitializeClient() {
 
     // Wait for all connections to be established
     uint32 numConn = 3;
-    while (endpoint_->GetRemoteNames().size() < numConn) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-    }
+    endpoint_->WaitForConnections(numConn);
     endpoint_->StopListen();
 
-    NTL::SetSeed(NTL::conv<NTL::ZZ>(options_.keys_seed));
-    key_gen(&keys_, 2048, options_.num_parties-1, options_.num_parties);
-    NTL::SetSeed(NTL::conv<NTL::ZZ>((long) time(nullptr)));
+    // The keys are derived from the keys seed, the protocol continues with the generator the party was seeded with
+    NTL::ZZ seed = NTL::RandomBits_ZZ(256);
+    CachedKeyGen(&keys_, options_.key_cache_dir, options_.keys_seed, 2048, options_.num_parties-1, options_.num_parties,
+                 options_.num_threads);
+    NTL::SetSeed(seed);
+    paillier_ = std::make_unique<PaillierContext>(keys_.public_key);
+
+    InitializePackings();
+
+    // Encrypt the Bloom filter of the first execution ahead of time
+    encryption_pool_ = std::make_unique<EncryptionPool>(keys_.public_key);
+    encryption_pool_->Fill(options_.bloom_filter_size, options_.num_threads);
 }
 
 // Initialize the server participant
@@ -45,14 +57,29 @@ void Participant::InitializeServer() {
 
     // Wait for all connections to be established
     uint32 numConn = options_.num_parties + 1;
-    while (endpoint_->GetRemoteNames().size() < numConn) {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-    }
+    endpoint_->WaitForConnections(numConn);
     endpoint_->StopListen();
 
-    NTL::SetSeed(NTL::conv<NTL::ZZ>(options_.keys_seed));
-    key_gen(&keys_, 2048, options_.num_parties-1, options_.num_parties);
-    NTL::SetSeed(NTL::conv<NTL::ZZ>((long) time(nullptr)));
+    // The keys are derived from the keys seed, the protocol continues with the generator the party was seeded with
+    NTL::ZZ seed = NTL::RandomBits_ZZ(256);
+    CachedKeyGen(&keys_, options_.key_cache_dir, options_.keys_seed, 2048, options_.num_parties-1, options_.num_parties,
+                 options_.num_threads);
+    NTL::SetSeed(seed);
+    paillier_ = std::make_unique<PaillierContext>(keys_.public_key);
+    InitializePackings();
+}
+
+// Initialize the packings of the values the parties decrypt together, the same for all parties
+void Participant::InitializePackings() {
+    // An SCP starts from r * d - r' with |d| <= max(k, number of parties), and every client maps c to
+    // +-(r * c - r'), with r, r' < rRange
+    ZZ bound = ZZ(rRange) * (std::max<uint32>(options_.num_hash_functions, options_.num_parties) + 1);
+    for (uint32 i = 1; i < options_.num_parties; i++) {
+        bound = rRange * bound + rRange;
+    }
+    comparison_packing_ = std::make_unique<SlotPacking>(bound, keys_.public_key);
+    // The indicators of the elements are 0 or 1
+    indicator_packing_ = std::make_unique<SlotPacking>(ZZ(1), keys_.public_key);
 }
 
 // Execute the protocol
@@ -64,11 +91,13 @@ std::vector<long long> Participant::Execute(bool print) {
 
     auto start = std::chrono::high_resolution_clock::now();
 
+    endpoint_->SetPhase("Precompute");
     if (role() == Role::server) {
         PrecomputeServer();
     } else {
         PrecomputeClient();
     }
+    endpoint_->SetPhase("RingLatency");
     RingLatency(false);
 
     if (role() == Role::server) {
@@ -77,6 +106,13 @@ std::vector<long long> Participant::Execute(bool print) {
         ExecuteClient();
     }
     auto end = std::chrono::high_resolution_clock::now();
+    endpoint_->SetPhase(setupPhaseName);
+    WriteStatistics();
+
+    // Refill the pool for the next execution, outside of the measured time
+    if (role() == Role::client) {
+        encryption_pool_->Fill(options_.bloom_filter_size, options_.num_threads);
+    }
 
     auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count();
     std::vector<long long> durations = {dur};
@@ -91,46 +127,53 @@ std::vector<long long> Participant::Execute(bool print) {
 }
 
 
-void Participant::PrecomputeServer(){
-    one_encryptions_.clear();
-    zero_encryptions_.clear();
-    k_encryptions_.clear();
-    l_encryptions_.clear();
-    r_array_.clear();
-    r_prime_array_.clear();
-    r_prime_encrpytions_.clear();
-    uint32 scp_num = (options_.num_parties - 1) * elements_.size() + elements_.size();
-    if(one_encryptions_.capacity() < scp_num) {
-        one_encryptions_.reserve(scp_num);
-        zero_encryptions_.reserve(scp_num);
-        k_encryptions_.reserve(scp_num);
-        l_encryptions_.reserve(scp_num);
-        r_array_.reserve(scp_num);
-        r_prime_array_.reserve(scp_num);
-        r_prime_encrpytions_.reserve(scp_num);
+// Write the traffic statistics of the endpoint to the configured file, if any
+void Participant::WriteStatistics() const {
+    if (options_.statistics_output.empty()) {
+        return;
     }
-    for(auto i = 0; i < scp_num; i++){
-        one_encryptions_.push_back(encrypt(ZZ(1), keys_.public_key));
-        zero_encryptions_.push_back(encrypt(ZZ(0), keys_.public_key));
-        k_encryptions_.push_back(encrypt(ZZ(options_.num_hash_functions), keys_.public_key));
-        l_encryptions_.push_back(encrypt(ZZ(options_.intersection_threshold), keys_.public_key));
+    nlohmann::json statistics = {{"party",  options_.local_name},
+                                 {"phases", endpoint_->GetStatistics()}};
+    std::ofstream file(options_.statistics_output);
+    file << statistics.dump(4) << std::endl;
+}
 
-        ZZ r = RandomBnd(NTL::ZZ(rRange - 1)) + 1;
-        ZZ r_prime = RandomBnd(r - 1) + 1;
-        r_array_.push_back(r);
-        r_prime_encrpytions_.push_back(encrypt(r_prime, keys_.public_key));
+void Participant::PrecomputeServer(){
+    // The numbers keep their storage from round to round, the encryptions are written into them in place
+    const ZZ one(1), zero(0), k(options_.num_hash_functions), l(options_.intersection_threshold);
+    const ZZ r_bound(rRange - 2);
+    ZZ r_prime_bound, r_prime;
+    uint32 scp_num = (options_.num_parties - 1) * elements_.size() + elements_.size();
+    one_encryptions_.resize(scp_num);
+    zero_encryptions_.resize(scp_num);
+    k_encryptions_.resize(scp_num);
+    l_encryptions_.resize(scp_num);
+    r_array_.resize(scp_num);
+    offset_encryptions_.clear();
+    swaps_.clear();
+    negated_r_prime_encryptions_.resize(scp_num);
+    for(uint32 i = 0; i < scp_num; i++){
+        paillier_->EncryptInto(one_encryptions_[i], one);
+        paillier_->EncryptInto(zero_encryptions_[i], zero);
+        paillier_->EncryptInto(k_encryptions_[i], k);
+        paillier_->EncryptInto(l_encryptions_[i], l);
+
+        // r in [2, rRange - 1], r' in [1, r - 1], r' is encrypted negated so that the SCP adds it. r = 1 would force
+        // r' = r, which turns a difference of one into a comparison result of zero
+        NTL::RandomBnd(r_array_[i], r_bound);
+        NTL::add(r_array_[i], r_array_[i], 2);
+        NTL::sub(r_prime_bound, r_array_[i], 1);
+        NTL::RandomBnd(r_prime, r_prime_bound);
+        NTL::add(r_prime, r_prime, 1);
+        NTL::negate(r_prime, r_prime);
+        paillier_->EncryptInto(negated_r_prime_encryptions_[i], r_prime);
     }
 
-
-    rerands_.clear();
     uint32 rerands_size = elements_.size() * (options_.num_parties-1);
     rerands_size += 2 * elements_.size();
-    if(rerands_.capacity() < rerands_size){
-        rerands_.reserve(rerands_size);
-    }
-
-    for(auto i = 0; i < rerands_size; i++){
-        rerands_.push_back(encrypt(ZZ(0), keys_.public_key));
+    rerands_.resize(rerands_size);
+    for(uint32 i = 0; i < rerands_size; i++){
+        paillier_->EncryptInto(rerands_[i], zero);
     }
 
     rerand_count_ = 0;
@@ -139,37 +182,41 @@ void Participant::PrecomputeServer(){
 
 void Participant::PrecomputeClient(){
     bf_.clear();
-    for (long element : elements_) {
-        bf_.insert(element);
-    }
-    bf_.encrypt_all(ebf_, keys_.public_key);
+    bf_.insert_all(elements_, options_.num_threads);
+    bf_.encrypt_all(ebf_, *encryption_pool_, options_.num_threads);
 
-    r_array_.clear();
-    r_prime_array_.clear();
-    r_prime_encrpytions_.clear();
+    // All randomness of the SCPs is drawn here, so passing an SCP on only multiplies and adds ciphertexts
+    const ZZ zero(0), r_bound(rRange - 2);
+    ZZ r_prime_bound, r_prime;
     uint32 scp_num = (options_.num_parties - 1) * elements_.size() + elements_.size();
-    if(r_array_.capacity() < scp_num) {
-        r_array_.reserve(scp_num);
-        r_prime_array_.reserve(scp_num);
-        r_prime_encrpytions_.reserve(scp_num);
-    }
-
-    for(auto i = 0; i < (options_.num_parties-1) * elements_.size() + elements_.size(); i++){
-        ZZ r = RandomBnd(NTL::ZZ(rRange - 1)) + 1;
-        ZZ r_prime = RandomBnd(r - 1) + 1;
-        r_array_.push_back(r);
-        r_prime_array_.push_back(r_prime);
+    r_array_.resize(scp_num);
+    offset_encryptions_.resize(scp_num);
+    swaps_.resize(scp_num);
+    negated_r_prime_encryptions_.clear();
+    for(uint32 i = 0; i < scp_num; i++){
+        // r in [2, rRange - 1], r' in [1, r - 1], as on the server
+        NTL::RandomBnd(r_array_[i], r_bound);
+        NTL::add(r_array_[i], r_array_[i], 2);
+        NTL::sub(r_prime_bound, r_array_[i], 1);
+        NTL::RandomBnd(r_prime, r_prime_bound);
+        NTL::add(r_prime, r_prime, 1);
+
+        // c becomes (-2b + 1) * r * c + (2b - 1) * r' for a random bit b, which also decides whether a_1 and a_2
+        // are swapped
+        swaps_[i] = NTL::RandomBits_long(1);
+        if (swaps_[i]) {
+            NTL::negate(r_array_[i], r_array_[i]);
+        } else {
+            NTL::negate(r_prime, r_prime);
+        }
+        paillier_->EncryptInto(offset_encryptions_[i], r_prime);
     }
 
-    rerands_.clear();
     uint32 rerands_size = 2 * (options_.num_parties-1) * elements_.size();
     rerands_size += 2 * (elements_.size());
-    if(rerands_.capacity() < rerands_size) {
-        rerands_.reserve(rerands_size);
-    }
-
-    for(auto i = 0; i < rerands_size; i++){
-        rerands_.push_back(encrypt(ZZ(0), keys_.public_key));
+    rerands_.resize(rerands_size);
+    for(uint32 i = 0; i < rerands_size; i++){
+        paillier_->EncryptInto(rerands_[i], zero);
     }
     rerand_count_ = 0;
     scp_count_ = 0;
@@ -179,300 +226,222 @@ void Participant::PrecomputeClient(){
 // Execute the protocol
 std::vector<long> Participant::ExecuteServer(){
     // receive ebf from all
+    endpoint_->SetPhase("EbfUpload");
     std::vector<std::vector<ZZ>> client_ebfs;
     client_ebfs.reserve(options_.num_parties-1);
-    ZZ temp;
     for (const auto &remote: options_.party_list) {
-        std::vector<ZZ> ebf;
-        ebf.reserve(options_.bloom_filter_size);
         if (remote == options_.local_name) {
             continue;
         }
-        for(auto i = 0; i < options_.bloom_filter_size; i++){
-            ReceiveZz(remote, temp);
-            ebf.emplace_back(temp);
+        std::vector<ZZ> &ebf = client_ebfs.emplace_back(options_.bloom_filter_size);
+        for (uint64 i = 0; i < options_.bloom_filter_size; i += options_.batch_size) {
+            ReceiveZzBatch(remote, &ebf[i], std::min<uint64>(options_.batch_size, options_.bloom_filter_size - i));
         }
-
-        client_ebfs.emplace_back(ebf);
-    }
-
-    std::vector<std::vector<ZZ>> client_ciphertexts;
-    client_ciphertexts.reserve(options_.num_parties-1);
-    for (int i = 0; i < options_.num_parties-1; ++i) {
-        // Initialize an empty set for each client
-        client_ciphertexts.emplace_back();
     }
 
+    // The numbers below are allocated up front and the Paillier context writes into them in place, so the loops over
+    // the clients, elements and hash functions do not allocate. The ciphertexts of all clients are laid out one client
+    // after another
+    uint64 num_clients = client_ebfs.size();
+    uint64 num_elements = elements_.size();
+    std::vector<ZZ> client_ciphertexts(num_clients * num_elements);
+    std::vector<ZZ> client_ciphertext(num_clients);
+    for (uint64 e = 0; e < num_elements; ++e) {
+        long element = elements_[e];
 
-    for (long element : elements_) {
         // Compute for the first hash function
         unsigned long index = BloomFilter::hash(element, 0) % options_.bloom_filter_size;
-
-        std::vector<ZZ> client_ciphertext;
-        client_ciphertext.reserve(options_.num_parties-1);
-        for (int i = 0; i < options_.num_parties-1; ++i) {
-            client_ciphertext.push_back(client_ebfs.at(i).at(index));
+        for (uint64 i = 0; i < num_clients; ++i) {
+            client_ciphertext[i] = client_ebfs[i][index];
         }
 
         // Compute for the remaining hash functions
-        for (int i = 1; i < options_.num_hash_functions; ++i) {
-            for (int j = 0; j < options_.num_parties-1; ++j) {
-                index = BloomFilter::hash(element, i) % options_.bloom_filter_size;
-
-                client_ciphertext.at(j) = add_homomorphically(client_ciphertext.at(j),
-                                                              client_ebfs.at(j).at(index),
-                                                              keys_.public_key);
+        for (uint32 i = 1; i < options_.num_hash_functions; ++i) {
+            index = BloomFilter::hash(element, i) % options_.bloom_filter_size;
+            for (uint64 j = 0; j < num_clients; ++j) {
+                paillier_->AddInto(client_ciphertext[j], client_ciphertext[j], client_ebfs[j][index]);
             }
         }
 
         // Rerandomize the ciphertext to prevent analysis due to the deterministic nature of homomorphic addition
-        for (int i = 0; i < options_.num_parties-1; ++i) {
-            client_ciphertexts.at(i).push_back(add_homomorphically(client_ciphertext.at(i), rerands_[rerand_count_++], keys_.public_key));
+        for (uint64 i = 0; i < num_clients; ++i) {
+            paillier_->AddInto(client_ciphertexts[i * num_elements + e], client_ciphertext[i],
+                               rerands_[rerand_count_++]);
         }
     }
 
-    std::vector<std::vector<ZZ>> client_comparisons;
-    client_comparisons.reserve(client_ciphertexts.size());
-
-    // first round scps
-    for (int i = 0; i < client_ciphertexts.size(); ++i) {
-        ZZ a,b, difference, a_1, a_2, c_encrypted;
-        for (int j = 0; j < client_ciphertexts.at(i).size(); ++j) {
-            // 1. Party X_1 computes the encryption of c = r(x_0 - x_1) - r', where r and r' are random
-            a = k_encryptions_[scp_count_];
-            b = client_ciphertexts.at(i).at(j);
-
-            difference = subtract_homomorphically(a, b, keys_.public_key);
-            c_encrypted = subtract_homomorphically(multiply_homomorphically(difference, r_array_[scp_count_], keys_.public_key),
-                                                      r_prime_encrpytions_[scp_count_],
-                                                      keys_.public_key);
+    // first round scps, compare the count of every element with k
+    endpoint_->SetPhase("FirstScp");
+    std::vector<ZZ> a_1_array, a_2_array;
+    std::vector<const ZZ *> client_comparisons;
+    ScpServer(client_ciphertexts, k_encryptions_, a_1_array, a_2_array, client_comparisons);
 
-            // 2. Send ciphertexts to other parties, with a_1 = Enc(1), a_2 = Enc(0), (a_3 = c_encrypted)
-            a_1 = one_encryptions_[scp_count_];
-            a_2 = zero_encryptions_[scp_count_++];
-
-            SendZz(rightNeighborName, a_1);
-            SendZz(rightNeighborName, a_2);
-            SendZz(rightNeighborName, c_encrypted);
+    std::vector<ZZ> summed_comparisons(num_elements);
+    for (uint64 i = 0; i < num_elements; ++i) {
+        // Initialize with the first client
+        ZZ &sum = summed_comparisons[i];
+        sum = *client_comparisons[i];
 
+        // Add remaining elements from other clients
+        for (uint64 j = 1; j < num_clients; ++j) {
+            paillier_->AddInto(sum, sum, *client_comparisons[j * num_elements + i]);
         }
 
+        // Rerandomize
+        paillier_->AddInto(sum, sum, rerands_[rerand_count_++]);
     }
 
-    std::vector<std::vector<ZZ>> a_1_arrays, a_2_arrays, c_encrypted_arrays;
-    a_1_arrays.reserve(client_ciphertexts.size());
-    a_2_arrays.reserve(client_ciphertexts.size());
-    c_encrypted_arrays.reserve(client_ciphertexts.size());
-
-    for (int i = 0; i < client_ciphertexts.size(); ++i) {
-        std::vector<ZZ> a_1_array, a_2_array, c_encrypted_array;
-        a_1_array.reserve(client_ciphertexts.at(i).size());
-        a_2_array.reserve(client_ciphertexts.at(i).size());
-        c_encrypted_array.reserve(client_ciphertexts.at(i).size());
-        ZZ a_1, a_2, c_encrypted;
-        for (int j = 0; j < client_ciphertexts.at(i).size(); ++j) {
-            ReceiveZz(leftNeighborName, a_1);
-            ReceiveZz(leftNeighborName, a_2);
-            ReceiveZz(leftNeighborName, c_encrypted);
-
-            a_1_array.push_back(a_1);
-            a_2_array.push_back(a_2);
-            c_encrypted_array.push_back(c_encrypted);
-        }
+    // second round scps, compare the number of clients holding every element with l
+    endpoint_->SetPhase("SecondScp");
+    std::vector<const ZZ *> element_comparisons;
+    ScpServer(summed_comparisons, l_encryptions_, a_1_array, a_2_array, element_comparisons);
 
-        a_1_arrays.push_back(a_1_array);
-        a_2_arrays.push_back(a_2_array);
-        c_encrypted_arrays.push_back(c_encrypted_array);
+    std::vector<ZZ> element_ciphertexts(num_elements);
+    for (uint64 i = 0; i < num_elements; ++i) {
+        paillier_->AddInto(element_ciphertexts[i], *element_comparisons[i], rerands_[rerand_count_++]);
     }
 
-    for (int i = 0; i < client_ciphertexts.size(); ++i) {
-        std::vector<ZZ> comparisons;
-        comparisons.reserve(client_ciphertexts.at(i).size());
-        ZZ a_1, a_2, c_encrypted;
-        for (int j = 0; j < client_ciphertexts.at(i).size(); ++j) {
-            a_1 = a_1_arrays[i][j];
-            a_2 = a_2_arrays[i][j];
-            c_encrypted = c_encrypted_arrays[i][j];
-
-            std::vector<std::pair<long, ZZ>> decryption_shares;
-            BroadcastZz(c_encrypted);
-
-            ZZ share = partial_decrypt(c_encrypted, keys_.public_key,
-                                       keys_.private_keys.at(index_-1));
-            decryption_shares.emplace_back(1, share);
-
-            for(auto k = 2; k <= options_.num_parties; k++){
-                ReceiveZz("P"+std::to_string(k), share);
-                decryption_shares.emplace_back(k, share);
-            }
-
+    endpoint_->SetPhase("Decrypt");
+    std::vector<ZZ> decryptions;
+    DecryptPacked(*indicator_packing_, element_ciphertexts.data(), element_ciphertexts.size(), decryptions);
 
-            if (combine_partial_decrypt(decryption_shares, keys_.public_key) <= 0) {
-                comparisons.push_back(a_1);
-            } else {
-                comparisons.push_back(a_2);
-            }
 
+    // Output the final intersection by selecting the elements from the server set that correspond to a decryption of one (true)
+    std::vector<long> intersection;
+    for (uint64 i = 0; i < elements_.size(); ++i) {
+        if (decryptions.at(i) == 1) {
+            intersection.push_back(elements_.at(i));
         }
-        client_comparisons.push_back(comparisons);
     }
 
-    std::vector<ZZ> summed_comparisons;
-    summed_comparisons.reserve(elements_.size());
-    for (int i = 0; i < elements_.size(); ++i) {
-        // Initialize with the first client
-        ZZ sum = client_comparisons.at(0).at(i);
+    return intersection;
+}
 
-        // Add remaining elements from other clients
-        for (int j = 1; j < client_comparisons.size(); ++j) {
-            sum = add_homomorphically(sum, client_comparisons.at(j).at(i), keys_.public_key);
+// Run the SCPs of the server that compare the plaintexts of values with those of the constants of the next SCPs, in
+// a pipeline of batches of batchSize SCPs: batch b + 1 is sent around the ring before batch b comes back and is
+// decrypted, so while the server waits for the shares of batch b the clients work on batch b + 1. For every SCP,
+// comparisons points to the Enc(1) or Enc(0) that came back in a_1 or a_2 and was selected by the decrypted c. The
+// values are negated in place.
+void Participant::ScpServer(std::vector<NTL::ZZ> &values, const std::vector<NTL::ZZ> &constants,
+                            std::vector<NTL::ZZ> &a_1, std::vector<NTL::ZZ> &a_2,
+                            std::vector<const NTL::ZZ *> &comparisons) {
+    uint64 count = values.size();
+    uint64 first = scp_count_;
+    a_1.resize(count);
+    a_2.resize(count);
+    comparisons.resize(count);
+    std::vector<ZZ> c_encrypted(count), decryptions;
+    ZZ difference;
+
+    // Negate the values with one inversion, so every SCP only adds
+    paillier_->NegateBatchInto(values.data(), values.data(), static_cast<long>(count));
+
+    auto send_batch = [&](uint64 begin) {
+        uint64 size = std::min<uint64>(options_.batch_size, count - begin);
+        for (uint64 i = begin; i < begin + size; ++i) {
+            // 1. Party X_1 computes the encryption of c = r(x_0 - x_1) - r', where r and r' are random
+            paillier_->AddInto(difference, constants[first + i], values[i]);
+            paillier_->MultiplyInto(difference, difference, r_array_[first + i]);
+            paillier_->AddInto(c_encrypted[i], difference, negated_r_prime_encryptions_[first + i]);
         }
 
-        // Rerandomize
-        summed_comparisons.push_back(add_homomorphically(sum, rerands_[rerand_count_++], keys_.public_key));
-    }
-
-    std::vector<ZZ> element_ciphertexts;
-    element_ciphertexts.reserve(summed_comparisons.size());
-
-    // second round scps
-    for (auto & summed_comparison : summed_comparisons) {
-        ZZ a = l_encryptions_[scp_count_];
-        ZZ b = summed_comparison;
-
-        ZZ difference = subtract_homomorphically(a, b, keys_.public_key);
-        ZZ c_encrypted = subtract_homomorphically(multiply_homomorphically(difference, r_array_[scp_count_], keys_.public_key),
-                                                  r_prime_encrpytions_[scp_count_],
-                                                  keys_.public_key);
-
         // 2. Send ciphertexts to other parties, with a_1 = Enc(1), a_2 = Enc(0), (a_3 = c_encrypted)
-        ZZ a_1 = one_encryptions_[scp_count_];
-        ZZ a_2 = zero_encryptions_[scp_count_++];
-
-        SendZz(rightNeighborName, a_1);
-        SendZz(rightNeighborName, a_2);
-        SendZz(rightNeighborName, c_encrypted);
-    }
-
-    std::vector<ZZ> a_1_array, a_2_array, c_encrypted_array;
-    a_1_array.reserve(elements_.size());
-    a_2_array.reserve(elements_.size());
-    c_encrypted_array.reserve(elements_.size());
-    for (auto & summed_comparison : summed_comparisons) {
-        ZZ a_1, a_2, c_encrypted, temp;
-        ReceiveZz(leftNeighborName, a_1);
-        ReceiveZz(leftNeighborName, a_2);
-        ReceiveZz(leftNeighborName, c_encrypted);
-
-        a_1_array.push_back(a_1);
-        a_2_array.push_back(a_2);
-        c_encrypted_array.push_back(c_encrypted);
-    }
-
-    int i = 0;
-    for (auto & summed_comparison : summed_comparisons) {
-        ZZ a_1 = a_1_array[i];
-        ZZ a_2 = a_2_array[i];
-        ZZ c_encrypted = c_encrypted_array[i++];
-        std::vector<std::pair<long, ZZ>> decryption_shares;
-        BroadcastZz(c_encrypted);
-
-        ZZ share = partial_decrypt(c_encrypted, keys_.public_key,
-                                   keys_.private_keys.at(index_-1));
-        decryption_shares.emplace_back(1, share);
-
-        for(auto k = 2; k <= options_.num_parties; k++){
-            ReceiveZz("P"+std::to_string(k), share);
-            decryption_shares.emplace_back(k, share);
+        SendZzBatch(rightNeighborName, &one_encryptions_[first + begin], size);
+        SendZzBatch(rightNeighborName, &zero_encryptions_[first + begin], size);
+        SendZzBatch(rightNeighborName, &c_encrypted[begin], size);
+    };
+
+    if (count > 0) {
+        send_batch(0);
+    }
+    for (uint64 begin = 0; begin < count; begin += options_.batch_size) {
+        uint64 size = std::min<uint64>(options_.batch_size, count - begin);
+        if (begin + size < count) {
+            send_batch(begin + size);
         }
 
-        if (combine_partial_decrypt(decryption_shares, keys_.public_key) <= 0) {
-            temp = a_1;
-        } else {
-            temp = a_2;
+        ReceiveZzBatch(leftNeighborName, &a_1[begin], size);
+        ReceiveZzBatch(leftNeighborName, &a_2[begin], size);
+        ReceiveZzBatch(leftNeighborName, &c_encrypted[begin], size);
+        DecryptPacked(*comparison_packing_, &c_encrypted[begin], size, decryptions);
+        for (uint64 i = 0; i < size; ++i) {
+            comparisons[begin + i] = decryptions[i] <= 0 ? &a_1[begin + i] : &a_2[begin + i];
         }
-
-
-        element_ciphertexts.push_back(add_homomorphically(temp, rerands_[rerand_count_++], keys_.public_key));
     }
+    scp_count_ += count;
+}
 
-
-
-
-    std::vector<ZZ> decryptions;
-    decryptions.reserve(element_ciphertexts.size());
-    for (ZZ ciphertext : element_ciphertexts) {
-        // Partial decryption (let threshold + 1 parties decrypt)
-        std::vector<std::pair<long, ZZ>> decryption_shares;
-        decryption_shares.reserve(options_.num_parties);
-        BroadcastZz(ciphertext);
-
-        ZZ share = partial_decrypt(ciphertext, keys_.public_key,
-                                   keys_.private_keys.at(index_-1));
-        decryption_shares.emplace_back(1, share);
-
-        for(auto k = 2; k <= options_.num_parties; k++){
-            ReceiveZz("P"+std::to_string(k), share);
-            decryption_shares.emplace_back(k, share);
+// Decrypt count ciphertexts with the clients, packed into as few ciphertexts as the packing allows. The packed
+// ciphertexts are broadcast in one batch and every client returns its shares of them in one batch
+void Participant::DecryptPacked(const SlotPacking &packing, const NTL::ZZ *ciphertexts, uint64 count,
+                                std::vector<NTL::ZZ> &values) {
+    uint64 packed_count = packing.PackedCount(count);
+    std::vector<NTL::ZZ> packed(packed_count);
+    for (uint64 p = 0; p < packed_count; p++) {
+        uint64 begin = p * packing.slots();
+        packing.PackInto(packed[p], ciphertexts + begin, static_cast<long>(std::min<uint64>(packing.slots(),
+                                                                                              count - begin)),
+                         *paillier_);
+    }
+    for (const auto &remote: options_.party_list) {
+        if (remote != options_.local_name) {
+            SendZzBatch(remote, packed.data(), packed_count);
         }
-
-        // Combining algorithm
-        decryptions.push_back(combine_partial_decrypt(decryption_shares,
-                                                      keys_.public_key));
     }
 
+    // The shares of party k are in party_shares[k - 1], the own ones first
+    std::vector<std::vector<NTL::ZZ>> party_shares(options_.num_parties, std::vector<NTL::ZZ>(packed_count));
+    for (uint64 p = 0; p < packed_count; p++) {
+        paillier_->PartialDecryptInto(party_shares[0][p], packed[p], keys_.private_keys.at(index_-1));
+    }
+    for (uint32 k = 2; k <= options_.num_parties; k++) {
+        ReceiveZzBatch("P" + std::to_string(k), party_shares[k - 1].data(), packed_count);
+    }
 
-    // Output the final intersection by selecting the elements from the server set that correspond to a decryption of one (true)
-    std::vector<long> intersection;
-    for (int i = 0; i < elements_.size(); ++i) {
-        if (decryptions.at(i) == 1) {
-            intersection.push_back(elements_.at(i));
+    values.resize(count);
+    std::vector<std::pair<long, NTL::ZZ>> shares(options_.num_parties);
+    for (uint64 p = 0; p < packed_count; p++) {
+        for (uint32 k = 1; k <= options_.num_parties; k++) {
+            shares[k - 1].first = k;
+            NTL::swap(shares[k - 1].second, party_shares[k - 1][p]);
         }
+        uint64 begin = p * packing.slots();
+        packing.Unpack(&values[begin], combine_partial_decrypt(shares, keys_.public_key),
+                       static_cast<long>(std::min<uint64>(packing.slots(), count - begin)));
     }
+}
 
-    return intersection;
+// Partially decrypt the packed ciphertexts of count values the server decrypts with DecryptPacked
+void Participant::DecryptPackedClient(const SlotPacking &packing, uint64 count) {
+    uint64 packed_count = packing.PackedCount(count);
+    std::vector<NTL::ZZ> ciphertexts(packed_count), shares(packed_count);
+    ReceiveZzBatch(serverName, ciphertexts.data(), packed_count);
+    for (uint64 p = 0; p < packed_count; p++) {
+        paillier_->PartialDecryptInto(shares[p], ciphertexts[p], keys_.private_keys.at(index_-1));
+    }
+    SendZzBatch(serverName, shares.data(), packed_count);
 }
 
 // Execute the protocol
 void Participant::ExecuteClient(){
 
     // send ebf to server
-    for(auto i = 0; i < options_.bloom_filter_size; i++){
-        SendZz(serverName, ebf_[i]);
+    endpoint_->SetPhase("EbfUpload");
+    for (uint64 i = 0; i < options_.bloom_filter_size; i += options_.batch_size) {
+        SendZzBatch(serverName, &ebf_[i], std::min<uint64>(options_.batch_size, options_.bloom_filter_size - i));
     }
 
     // first round scps
-    for (auto i = 0; i < options_.num_parties-1; ++i) {
-        for (auto j = 0; j < elements_.size(); ++j) {
-           ScpClient();
-        }
-    }
-    ZZ c_encrypted;
-    for (auto i = 0; i < options_.num_parties-1; ++i) {
-        for (auto j = 0; j < elements_.size(); ++j) {
-            ReceiveZz(serverName, c_encrypted);
-            SendZz(serverName, partial_decrypt(c_encrypted, keys_.public_key,
-                                               keys_.private_keys.at(index_-1)));
-        }
-    }
-
+    endpoint_->SetPhase("FirstScp");
+    ScpClient((options_.num_parties - 1) * elements_.size());
 
     //second round scps
-    for (auto i = 0; i < elements_.size(); i++){
-        ScpClient();
-    }
-    for (auto i = 0; i < elements_.size(); i++){
-        ReceiveZz(serverName, c_encrypted);
-        SendZz(serverName, partial_decrypt(c_encrypted, keys_.public_key,
-                                           keys_.private_keys.at(index_-1)));
-    }
+    endpoint_->SetPhase("SecondScp");
+    ScpClient(elements_.size());
 
     // decrypt
-    for (auto i = 0; i < elements_.size(); i++){
-        ReceiveZz(serverName, c_encrypted);
-        SendZz(serverName, partial_decrypt(c_encrypted, keys_.public_key,
-                                           keys_.private_keys.at(index_-1)));
-    }
+    endpoint_->SetPhase("Decrypt");
+    DecryptPackedClient(*indicator_packing_, elements_.size());
 }
 
 
@@ -514,32 +483,46 @@ void Participant::ExecuteClient(){
 //
 //}
 
-void Participant::ScpClient(){
-    ZZ a_1, a_2, c_encrypted;
-
-    ReceiveZz(leftNeighborName, a_1);
-    ReceiveZz(leftNeighborName, a_2);
-    ReceiveZz(leftNeighborName, c_encrypted);
-
-
-    bool b_i = rand() % 2;  // TODO: Check randomness
-    if (b_i) {
-        // Swap a_1 and a_2 with uniform probability
-        std::swap(a_1, a_2);
-    }
+// Run count SCPs of a client in the pipeline of batches of ScpServer: batch b + 1 is passed on along the ring before
+// the client takes part in the decryption of batch b
+void Participant::ScpClient(uint64 count) {
+    std::vector<ZZ> a_1(options_.batch_size), a_2(options_.batch_size), c_encrypted(options_.batch_size);
+
+    auto pass_batch = [&](uint64 begin) {
+        uint64 size = std::min<uint64>(options_.batch_size, count - begin);
+        ReceiveZzBatch(leftNeighborName, a_1.data(), size);
+        ReceiveZzBatch(leftNeighborName, a_2.data(), size);
+        ReceiveZzBatch(leftNeighborName, c_encrypted.data(), size);
+
+        for (uint64 i = 0; i < size; ++i) {
+            if (swaps_[scp_count_]) {
+                // Swap a_1 and a_2 with uniform probability
+                NTL::swap(a_1[i], a_2[i]);
+            }
 
-    a_1 = add_homomorphically(a_1, rerands_[rerand_count_++], keys_.public_key);
-    a_2 = add_homomorphically(a_2, rerands_[rerand_count_++], keys_.public_key);
+            paillier_->AddInto(a_1[i], a_1[i], rerands_[rerand_count_++]);
+            paillier_->AddInto(a_2[i], a_2[i], rerands_[rerand_count_++]);
 
+            // c = (-2b + 1) * r * c + (2b - 1) * r', with the signs applied in PrecomputeClient
+            paillier_->MultiplyInto(c_encrypted[i], c_encrypted[i], r_array_[scp_count_]);
+            paillier_->AddInto(c_encrypted[i], c_encrypted[i], offset_encryptions_[scp_count_++]);
+        }
 
-    c_encrypted = multiply_homomorphically(c_encrypted, ZZ((-2 * b_i + 1) * r_array_[scp_count_]), keys_.public_key);
-    c_encrypted = add_homomorphically(c_encrypted,
-                                      encrypt(ZZ((b_i * 2 - 1) * r_prime_array_[scp_count_++]), keys_.public_key),
-                                      keys_.public_key);
+        SendZzBatch(rightNeighborName, a_1.data(), size);
+        SendZzBatch(rightNeighborName, a_2.data(), size);
+        SendZzBatch(rightNeighborName, c_encrypted.data(), size);
+    };
 
-    SendZz(rightNeighborName, a_1);
-    SendZz(rightNeighborName, a_2);
-    SendZz(rightNeighborName, c_encrypted);
+    if (count > 0) {
+        pass_batch(0);
+    }
+    for (uint64 begin = 0; begin < count; begin += options_.batch_size) {
+        uint64 size = std::min<uint64>(options_.batch_size, count - begin);
+        if (begin + size < count) {
+            pass_batch(begin + size);
+        }
+        DecryptPackedClient(*comparison_packing_, size);
+    }
 }
 
 
@@ -585,6 +568,36 @@ void Participant::BroadcastZz(const NTL::ZZ &n) {
     }
 }
 
+// Send a batch of numbers to a remote participant in one message
+void Participant::SendZzBatch(const std::string &remote, const NTL::ZZ *numbers, uint64 count) {
+    // A packed batch is preceded by its length, a fixed one is the same on the wire as its numbers sent one by one
+    wire_buffer_.resize(sizeof(uint32) + codec_.MaxEncodedSize(count));
+    auto len = static_cast<uint32>(codec_.Encode(wire_buffer_.data() + sizeof(uint32), numbers, count));
+    if (codec_.format() == ZzFormat::packed) {
+        std::memcpy(wire_buffer_.data(), &len, sizeof(len));
+        endpoint_->Write(remote, wire_buffer_.data(), sizeof(len) + len);
+    } else {
+        endpoint_->Write(remote, wire_buffer_.data() + sizeof(len), len);
+    }
+}
+
+// Receive a batch of numbers from a remote participant in one message
+void Participant::ReceiveZzBatch(const std::string &remote, NTL::ZZ *numbers, uint64 count) {
+    auto len = static_cast<uint32>(codec_.MaxEncodedSize(count));
+    if (codec_.format() == ZzFormat::packed) {
+        uint32 packed_len;
+        endpoint_->Read(remote, &packed_len, sizeof(packed_len));
+        if (packed_len > len) {
+            throw std::length_error("packed batch of " + std::to_string(packed_len) + " bytes from " + remote +
+                                    " exceeds " + std::to_string(len) + " bytes");
+        }
+        len = packed_len;
+    }
+    wire_buffer_.resize(len);
+    endpoint_->Read(remote, wire_buffer_.data(), len);
+    codec_.Decode(numbers, wire_buffer_.data(), count);
+}
+
 // Collect NTL::ZZs from all remote participants
 void Participant::CollectZz(std::vector<NTL::ZZ> &zz_array) {
     NTL::ZZ temp;
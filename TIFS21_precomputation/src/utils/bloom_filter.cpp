@@ -4,12 +4,17 @@
 
 #include "utils/bloom_filter.h"
 
+#include <algorithm>
+#include <atomic>
+
+#include "utils/parallel.h"
+
 
 /// Inserts the given element into the Bloom filter
 void BloomFilter::insert(long element) {
     for (unsigned long i = 0; i < this->k_hashes; ++i) {
         unsigned long index = BloomFilter::hash(element, i) % this->m_bits;
-        this->storage.at(index) = true;
+        this->set(index, false);
     }
 }
 
@@ -17,7 +22,7 @@ void BloomFilter::insert(long element) {
 bool BloomFilter::contains(long element) {
     for (unsigned long i = 0; i < this->k_hashes; ++i) {
         long index = BloomFilter::hash(element, i) % this->m_bits;
-        if (not this->storage.at(index)) {
+        if (not this->get(index)) {
             return false;
         }
     }
@@ -25,26 +30,62 @@ bool BloomFilter::contains(long element) {
     return true;
 }
 
-/// Inverts the Bloom filter in place so that all 0s become 1s and all 1s become 0s
-void BloomFilter::invert() {
-    for (long j = 0; j < this->m_bits; ++j) {
-        this->storage.at(j) = !this->storage.at(j);
-    }
+/// Inserts all given elements into the Bloom filter, split across num_threads threads that set the bits of the
+/// shared storage with atomic ORs
+void BloomFilter::insert_all(const std::vector<ElementType> &elements, unsigned int num_threads) {
+    ParallelFor(elements.size(), num_threads, [&](uint64 begin, uint64 end) {
+        // Only a range that is not the whole set shares the storage with other threads
+        bool concurrent = end - begin < elements.size();
+        for (uint64 e = begin; e < end; ++e) {
+            for (unsigned long i = 0; i < this->k_hashes; ++i) {
+                this->set(BloomFilter::hash(elements[e], i) % this->m_bits, concurrent);
+            }
+        }
+    });
+}
+
+/// Checks which of the given elements appear to have been inserted into the Bloom filter, on num_threads threads.
+/// found[i] is set to 1 if element i appears to have been inserted and to 0 otherwise
+void BloomFilter::contains_all(const std::vector<ElementType> &elements, std::vector<uint8> &found,
+                               unsigned int num_threads) const {
+    found.resize(elements.size());
+    ParallelFor(elements.size(), num_threads, [&](uint64 begin, uint64 end) {
+        for (uint64 e = begin; e < end; ++e) {
+            bool bit = true;
+            for (unsigned long i = 0; i < this->k_hashes && bit; ++i) {
+                bit = this->get(BloomFilter::hash(elements[e], i) % this->m_bits);
+            }
+            found[e] = bit;
+        }
+    });
 }
 
-/// Returns the bit-by-bit ciphertexts of the encrypted Bloom filter
-// TODO: Consider not passing ciphertexts by reference
-void BloomFilter::encrypt_all(std::vector<ZZ> &ciphertexts, PublicKey &public_key) {
-    ciphertexts.clear();
-    if(ciphertexts.capacity() < this->storage.size()) {
-        ciphertexts.reserve(this->storage.size());
+/// Inverts the Bloom filter in place so that all 0s become 1s and all 1s become 0s, a word at a time
+void BloomFilter::invert() {
+    for (uint64_t &word : this->storage) {
+        word = ~word;
     }
-    for (bool element : this->storage) {
-        // TODO: Maybe cast storage to long
-        ciphertexts.push_back(encrypt(ZZ(element), public_key));
+    if (this->m_bits % 64 != 0) {
+        this->storage.back() &= (uint64_t(1) << (this->m_bits % 64)) - 1;
     }
 }
 
+/// Returns the bit-by-bit ciphertexts of the encrypted Bloom filter, taken from a pool of encryptions of zero, which
+/// is filled first if it holds too few. The encryptions of the 1s are made from them with one multiplication by g, on
+/// num_threads threads
+void BloomFilter::encrypt_all(std::vector<ZZ> &ciphertexts, EncryptionPool &pool, unsigned int num_threads) {
+    pool.Fill(this->m_bits, num_threads);
+    pool.Take(ciphertexts, this->m_bits);
+    const PublicKey &public_key = pool.public_key();
+    ParallelFor(this->m_bits, num_threads, [&](uint64 begin, uint64 end) {
+        for (uint64 j = begin; j < end; ++j) {
+            if (this->get(j)) {
+                NTL::MulMod(ciphertexts[j], ciphertexts[j], public_key.g, public_key.n_squared);
+            }
+        }
+    });
+}
+
 /// Hashes the input with the given seed using MurmurHash3 and returns the first 32 bits as an unsigned long
 unsigned long BloomFilter::hash(long input, long seed) {
     unsigned long output[4];
@@ -56,7 +97,20 @@ unsigned long BloomFilter::hash(long input, long seed) {
 
 
 void BloomFilter::clear() {
-    for (long j = 0; j < this->m_bits; ++j) {
-        this->storage.at(j) = 0;
+    std::fill(this->storage.begin(), this->storage.end(), 0);
+}
+
+/// Returns the bit at the given index
+bool BloomFilter::get(unsigned long index) const {
+    return (this->storage[index / 64] >> (index % 64)) & 1;
+}
+
+/// Sets the bit at the given index, with an atomic OR if other threads set bits of the storage at the same time
+void BloomFilter::set(unsigned long index, bool concurrent) {
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if (concurrent) {
+        std::atomic_ref<uint64_t>(this->storage[index / 64]).fetch_or(bit, std::memory_order_relaxed);
+    } else {
+        this->storage[index / 64] |= bit;
     }
 }
@@ -1,6 +1,6 @@
 
-#include <cstdlib>
 #include <fstream>
+#include <thread>
 
 #include "protocol/participant.h"
 #include "third_party/smhasher/MurmurHash3.h"
@@ -14,8 +14,8 @@ int main(int argc, char *argv[]) {
     NewConfigFromJsonFile(config, argv[1]);
 
     std::vector<ElementType> set;
-    set.reserve(config.element_set_size);
     generate_set(set, config);
+    SeedRandomGenerator();
 
     std::vector<std::vector<long long>> durations;
     std::vector<uint64> data_send_amounts;
@@ -33,10 +33,8 @@ int main(int argc, char *argv[]) {
     participant.RingLatency(false);
     participant.RingLatency(true);
 
-    srand(time(0));
-    for (auto i = 0; i < config.benchmark_rounds; i++) {
+    for (uint32 i = 0; i < config.benchmark_rounds; i++) {
         config.same_item_seed += 1;
-        config.diff_item_seed += rand();
         generate_set(set, config);
         participant.ChangeElementSet(set);
         participant.RingLatency(false);
@@ -0,0 +1,80 @@
+#include <NTL/ZZ.h>
+
+#include <iomanip>
+#include <iostream>
+
+#include "microbenchmark.h"
+#include "utils/zz_codec.h"
+
+// Print the throughput of one variant, in GB of numbers per second
+static void Report(const std::string &name, uint64 bytes, double encode_seconds, double decode_seconds) {
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << bytes / encode_seconds / 1e9 << " GB/s encode"
+              << std::setw(10) << bytes / decode_seconds / 1e9 << " GB/s decode" << std::endl;
+}
+
+// Function to measure the throughput of the number codec against BytesFromZZ and ZZFromBytes.
+// Options: [--count <numbers>] [--width <bytes per number>] [--rounds <rounds>]
+int CodecBenchmark(const std::vector<std::string> &args) {
+    uint64 count = 1 << 16;
+    uint32 width = 256;
+    uint32 rounds = 10;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--count") {
+            count = std::stoul(args[i + 1]);
+        } else if (args[i] == "--width") {
+            width = std::stoul(args[i + 1]);
+        } else if (args[i] == "--rounds") {
+            rounds = std::stoul(args[i + 1]);
+        } else {
+            std::cerr << "unknown option " << args[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // Numbers of the full width, as ciphertexts modulo a prime of that size mostly are
+    std::vector<NTL::ZZ> numbers(count);
+    for (auto &n: numbers) {
+        NTL::RandomBits(n, 8 * width);
+    }
+    std::vector<NTL::ZZ> decoded(count);
+    std::vector<uint8> buffer(ZzCodec(width, ZzFormat::packed).MaxEncodedSize(count));
+    uint64 bytes = count * width * rounds;
+    std::cout << count << " numbers of " << width << " bytes, " << rounds << " rounds" << std::endl;
+
+    // One conversion per number, as SendZz and ReceiveZz do
+    auto start = std::chrono::steady_clock::now();
+    for (uint32 r = 0; r < rounds; r++) {
+        for (uint64 i = 0; i < count; i++) {
+            NTL::BytesFromZZ(buffer.data() + i * width, numbers[i], width);
+        }
+    }
+    double encode_seconds = SecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (uint32 r = 0; r < rounds; r++) {
+        for (uint64 i = 0; i < count; i++) {
+            decoded[i] = NTL::ZZFromBytes(buffer.data() + i * width, width);
+        }
+    }
+    Report("BytesFromZZ/ZZFromBytes", bytes, encode_seconds, SecondsSince(start));
+
+    for (auto format: {ZzFormat::fixed, ZzFormat::packed}) {
+        ZzCodec codec(width, format);
+        start = std::chrono::steady_clock::now();
+        for (uint32 r = 0; r < rounds; r++) {
+            codec.Encode(buffer.data(), numbers.data(), count);
+        }
+        encode_seconds = SecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (uint32 r = 0; r < rounds; r++) {
+            codec.Decode(decoded.data(), buffer.data(), count);
+        }
+        Report(format == ZzFormat::fixed ? "ZzCodec fixed" : "ZzCodec packed", bytes, encode_seconds,
+               SecondsSince(start));
+        if (decoded != numbers) {
+            std::cerr << "decoded numbers differ from the encoded ones" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
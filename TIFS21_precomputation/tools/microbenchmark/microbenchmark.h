@@ -0,0 +1,19 @@
+#ifndef OTMPSI_TOOLS_MICROBENCHMARK_H_
+#define OTMPSI_TOOLS_MICROBENCHMARK_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Function to measure the throughput of the number codec against BytesFromZZ and ZZFromBytes
+int CodecBenchmark(const std::vector<std::string> &args);
+
+// Function to check the Paillier operations against their reference versions and measure their throughput
+int PaillierBenchmark(const std::vector<std::string> &args);
+
+// Function to get the seconds elapsed since start
+inline double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif // OTMPSI_TOOLS_MICROBENCHMARK_H_
@@ -0,0 +1,237 @@
+#include <NTL/ZZ.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#include "crypto/key_cache.h"
+#include "crypto/slot_packing.h"
+#include "microbenchmark.h"
+
+namespace {
+
+// Print the throughput of one variant, in operations per second
+void Report(const std::string &name, uint64 operations, double seconds) {
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << operations / seconds << " /s" << std::endl;
+}
+
+// Function to decrypt a ciphertext with the shares of the first threshold_l + 1 parties
+ZZ Decrypt(PaillierContext &paillier, const ZZ &ciphertext, const Keys &keys) {
+    std::vector<std::pair<long, ZZ>> shares(paillier.public_key().threshold_l + 1);
+    for (size_t i = 0; i < shares.size(); ++i) {
+        shares[i].first = static_cast<long>(i + 1);
+        paillier.PartialDecryptInto(shares[i].second, ciphertext, keys.private_keys.at(i));
+    }
+    return combine_partial_decrypt(shares, paillier.public_key());
+}
+
+// Function to check that two sets of keys hold the same numbers, including the factorization and the table
+bool SameKeys(const Keys &a, const Keys &b) {
+    const PublicKey &x = a.public_key, &y = b.public_key;
+    if (x.g != y.g || x.n != y.n || x.n_squared != y.n_squared || x.theta != y.theta || x.delta != y.delta ||
+        x.threshold_l != y.threshold_l || x.combine_inverse != y.combine_inverse || a.private_keys != b.private_keys ||
+        !x.crt || !y.crt || !x.nth_residues || !y.nth_residues || !y.lagrange) {
+        return false;
+    }
+    const CrtParameters &c = *x.crt, &d = *y.crt;
+    if (c.p != d.p || c.q != d.q || c.p_squared != d.p_squared || c.q_squared != d.q_squared ||
+        c.phi_p_squared != d.phi_p_squared || c.phi_q_squared != d.phi_q_squared ||
+        c.q_squared_inverse != d.q_squared_inverse) {
+        return false;
+    }
+    return x.nth_residues->exponent_bits == y.nth_residues->exponent_bits &&
+           x.nth_residues->window_bits == y.nth_residues->window_bits &&
+           x.nth_residues->powers == y.nth_residues->powers;
+}
+
+// Function to check that the table holds powers[k][j] = h^(j * 2^(k * window_bits)) for an n-th residue h
+bool ValidTable(const PublicKey &public_key) {
+    const NthResidueTable &table = *public_key.nth_residues;
+    const ZZ &modulus = public_key.n_squared;
+    const ZZ phi = (public_key.crt->p - 1) * (public_key.crt->q - 1);
+    const ZZ &h = table.powers.at(0).at(1);
+
+    // The n-th residues are the subgroup of order phi(n) of the units modulo n^2
+    if (NTL::PowerMod(h, phi, modulus) != 1) {
+        return false;
+    }
+    for (size_t k = 0; k < table.powers.size(); ++k) {
+        const std::vector<ZZ> &powers = table.powers[k];
+        if (powers.size() != (1UL << table.window_bits) || powers[0] != 1 ||
+            powers[1] != NTL::PowerMod(h, NTL::power2_ZZ(k * table.window_bits), modulus)) {
+            return false;
+        }
+        for (size_t j = 2; j < powers.size(); ++j) {
+            if (powers[j] != NTL::MulMod(powers[j - 1], powers[1], modulus)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+// Function to measure the Paillier operations of the protocol and check them against their reference versions: the
+// key cache against the keys it stored, fixed-base encryption and CRT decryption against the plain ones modulo n^2,
+// batch negation against an inversion per ciphertext and packed decryption against one decryption per value.
+// Options: [--count <ciphertexts>] [--parties <t>] [--key_length <bits>] [--seed <seed>] [--key_cache_dir <dir>]
+int PaillierBenchmark(const std::vector<std::string> &args) {
+    uint64 count = 64;
+    uint32 parties = 3;
+    long key_length = 2048;
+    uint32 seed = 1;
+    std::string key_cache_dir;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--count") {
+            count = std::stoul(args[i + 1]);
+        } else if (args[i] == "--parties") {
+            parties = std::stoul(args[i + 1]);
+        } else if (args[i] == "--key_length") {
+            key_length = std::stol(args[i + 1]);
+        } else if (args[i] == "--seed") {
+            seed = std::stoul(args[i + 1]);
+        } else if (args[i] == "--key_cache_dir") {
+            key_cache_dir = args[i + 1];
+        } else {
+            std::cerr << "unknown option " << args[i] << std::endl;
+            return 1;
+        }
+    }
+    if (count == 0 || parties < 2) {
+        std::cerr << "needs at least one ciphertext and two parties" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Keys keys;
+    CachedKeyGen(&keys, key_cache_dir, seed, key_length, parties - 1, parties, 1);
+    std::cout << count << " ciphertexts, " << parties << " parties, keys of " << key_length << " bits in "
+              << std::setprecision(3) << SecondsSince(start) << " s" << std::endl;
+
+    // Key cache: the keys loaded from a file are the keys stored in it, and keys of other parameters are not loaded
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("paillier_benchmark_" + std::to_string(::getpid()) + ".bin")).string();
+    StoreKeys(keys, path, seed, key_length);
+    Keys loaded, other;
+    start = std::chrono::steady_clock::now();
+    bool same = LoadKeys(&loaded, path, seed, key_length, parties - 1, parties) && SameKeys(keys, loaded);
+    double load_seconds = SecondsSince(start);
+    bool rejected = !LoadKeys(&other, path, seed + 1, key_length, parties - 1, parties) &&
+                    !LoadKeys(&other, path, seed, key_length, parties, parties + 1);
+    std::filesystem::remove(path);
+    if (!same || !rejected) {
+        std::cerr << "the key cache does not round trip the keys" << std::endl;
+        return 1;
+    }
+    Report("LoadKeys", 1, load_seconds);
+
+    // The reference versions: uniform randomness r^n instead of the fixed-base table, and no factorization of n
+    PublicKey uniform_key = keys.public_key, plain_key = keys.public_key;
+    uniform_key.nth_residues = nullptr;
+    plain_key.crt = nullptr;
+    plain_key.nth_residues = nullptr;
+    PaillierContext paillier(keys.public_key), uniform(uniform_key), plain(plain_key);
+    if (!ValidTable(keys.public_key)) {
+        std::cerr << "the table of n-th residues does not hold the powers of an n-th residue" << std::endl;
+        return 1;
+    }
+
+    // Messages over the whole plaintext space, negative ones included
+    std::vector<ZZ> messages(count), ciphertexts(count), uniform_ciphertexts(count);
+    ZZ half = keys.public_key.n / 2;
+    for (auto &m: messages) {
+        NTL::RandomBnd(m, 2 * half);
+        m -= half;
+    }
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < count; i++) {
+        uniform.EncryptInto(uniform_ciphertexts[i], messages[i]);
+    }
+    Report("EncryptInto uniform r^n", count, SecondsSince(start));
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < count; i++) {
+        paillier.EncryptInto(ciphertexts[i], messages[i]);
+    }
+    Report("EncryptInto fixed-base", count, SecondsSince(start));
+
+    // Partial decryptions by the CRT against plain exponentiations modulo n^2, and the combined decryptions
+    std::vector<ZZ> shares(count), plain_shares(count);
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < count; i++) {
+        plain.PartialDecryptInto(plain_shares[i], ciphertexts[i], keys.private_keys[0]);
+    }
+    Report("PartialDecryptInto mod n^2", count, SecondsSince(start));
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < count; i++) {
+        paillier.PartialDecryptInto(shares[i], ciphertexts[i], keys.private_keys[0]);
+    }
+    Report("PartialDecryptInto CRT", count, SecondsSince(start));
+    if (shares != plain_shares) {
+        std::cerr << "the partial decryptions by the CRT differ from the ones modulo n^2" << std::endl;
+        return 1;
+    }
+    for (uint64 i = 0; i < count; i++) {
+        if (Decrypt(paillier, ciphertexts[i], keys) != messages[i] ||
+            Decrypt(plain, ciphertexts[i], keys) != messages[i] ||
+            Decrypt(paillier, uniform_ciphertexts[i], keys) != messages[i]) {
+            std::cerr << "a ciphertext does not decrypt to its message" << std::endl;
+            return 1;
+        }
+    }
+
+    // Batch negation against an inversion per ciphertext, into other numbers, in place and of a single ciphertext
+    std::vector<ZZ> expected(count), negated(count), in_place = ciphertexts;
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < count; i++) {
+        NTL::InvMod(expected[i], ciphertexts[i], keys.public_key.n_squared);
+    }
+    Report("InvMod", count, SecondsSince(start));
+    start = std::chrono::steady_clock::now();
+    paillier.NegateBatchInto(negated.data(), ciphertexts.data(), static_cast<long>(count));
+    Report("NegateBatchInto", count, SecondsSince(start));
+    paillier.NegateBatchInto(in_place.data(), in_place.data(), static_cast<long>(count));
+    ZZ single = ciphertexts[0];
+    paillier.NegateBatchInto(&single, &single, 1);
+    if (negated != expected || in_place != expected || single != expected[0] ||
+        Decrypt(paillier, negated[0], keys) != -messages[0]) {
+        std::cerr << "the batch negations differ from the inverses" << std::endl;
+        return 1;
+    }
+
+    // Packed decryption against one decryption per value, with values at both ends of the bound filling whole slots
+    const ZZ bound = ZZ(1) << 40;
+    SlotPacking packing(bound, keys.public_key);
+    uint64 slots = packing.slots(), value_count = std::max<uint64>(count, 2 * slots + 1);
+    std::vector<ZZ> values(value_count), encrypted(value_count), unpacked(value_count);
+    for (uint64 i = 0; i < value_count; i++) {
+        if (i < slots) {
+            values[i] = i % 2 == 0 ? -bound : bound;
+        } else {
+            NTL::RandomBnd(values[i], 2 * bound + 1);
+            values[i] -= bound;
+        }
+        paillier.EncryptInto(encrypted[i], values[i]);
+    }
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < value_count; i++) {
+        unpacked[i] = Decrypt(paillier, encrypted[i], keys);
+    }
+    Report("decrypt per value", value_count, SecondsSince(start));
+    std::vector<ZZ> from_packed(value_count);
+    ZZ packed;
+    start = std::chrono::steady_clock::now();
+    for (uint64 i = 0; i < value_count; i += slots) {
+        long n = static_cast<long>(std::min<uint64>(slots, value_count - i));
+        packing.PackInto(packed, &encrypted[i], n, paillier);
+        packing.Unpack(&from_packed[i], Decrypt(paillier, packed, keys), n);
+    }
+    Report("decrypt packed, per value", value_count, SecondsSince(start));
+    if (unpacked != values || from_packed != values) {
+        std::cerr << "the packed decryptions differ from the values" << std::endl;
+        return 1;
+    }
+    return 0;
+}